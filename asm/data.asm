@@ -0,0 +1,17 @@
+	.data 0xA000
+	.word 1, -2 0x10 010
+	.float 1.5, -0.25
+	.space 8
+	.word 0x7FFFFFFF
+	.data 0xC000
+	.float 2.0
+	XOR R0 R0 R0
+	LW R1 0xA000(R0)
+	LW R2 0xA008(R0)
+	ADD R3 R1 R2
+	SW R3 0xB000(R0)
+	LWS F1 0xA010(R0)
+	LWS F2 0xC000(R0)
+	MULTS F3 F1 F2
+	SWS F3 0xB004(R0)
+	EOP
@@ -0,0 +1,132 @@
+#include "checkpoint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+Checkpoint_Stream::Checkpoint_Stream(const char *filename, bool saving){
+	this->saving = saving;
+	this->filename = filename;
+	file = NULL;
+	failed = false;
+	data = NULL;
+	size = 0;
+	position = 0;
+	instr_memory = NULL;
+	instr_memory_size = 0;
+	if (saving){
+		file = fopen(filename, "wb");
+		if (file == NULL){
+			cerr << "error: open file " << filename << " failed!" << endl;
+			exit(-1);
+		}
+	} else {
+		int fd = open(filename, O_RDONLY);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) < 0){
+			cerr << "error: open file " << filename << " failed!" << endl;
+			exit(-1);
+		}
+		size = info.st_size;
+		if (size > 0){
+			data = (unsigned char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED){
+				cerr << "error: map file " << filename << " failed!" << endl;
+				exit(-1);
+			}
+		}
+		::close(fd);
+	}
+	char magic[sizeof(CHECKPOINT_MAGIC)] = CHECKPOINT_MAGIC;
+	unsigned version = CHECKPOINT_VERSION;
+	if (!saving && (size < sizeof magic || memcmp(data, CHECKPOINT_MAGIC, sizeof magic))){
+		cout << "ERROR:: " << filename << " is not a simulator checkpoint!\n";
+		exit(-1);
+	}
+	io_array(magic, sizeof magic);
+	io(version);
+	if (version != CHECKPOINT_VERSION){
+		cout << "ERROR:: checkpoint " << filename << " has version " << version << ", expected " << CHECKPOINT_VERSION << "!\n";
+		exit(-1);
+	}
+}
+
+Checkpoint_Stream::~Checkpoint_Stream(){
+	if (file != NULL) fclose(file);
+	if (data != NULL) munmap(data, size);
+}
+
+void Checkpoint_Stream::close(){
+	if (file == NULL) return;
+	if (fclose(file) != 0) failed = true;
+	file = NULL;
+	if (failed){
+		cout << "ERROR:: writing checkpoint " << filename << " failed!\n";
+		exit(-1);
+	}
+}
+
+void Checkpoint_Stream::io_bytes(void *buffer, size_t n){
+	if (saving){
+		if (fwrite(buffer, 1, n, file) != n) failed = true;
+	} else {
+		memcpy(buffer, map(n), n);
+		return;
+	}
+	position += n;
+}
+
+void Checkpoint_Stream::io_string(string &text){
+	unsigned length = text.size();
+	io(length);
+	if (saving){
+		io_bytes(const_cast<char *>(text.data()), length);
+	} else {
+		const unsigned char *chars = map(length);
+		text.assign((const char *)chars, length);
+	}
+}
+
+void Checkpoint_Stream::io_instr(const instruction_t *&instr){
+	unsigned index = (instr == NULL) ? UNDEFINED : instr - instr_memory;
+	io(index);
+	if (saving) return;
+	if (index != UNDEFINED && index >= instr_memory_size){
+		cout << "ERROR:: checkpoint instruction " << index << " out of the program!\n";
+		exit(-1);
+	}
+	instr = (index == UNDEFINED) ? NULL : instr_memory + index;
+}
+
+void Checkpoint_Stream::check(unsigned value, const char *what){
+	unsigned stored = value;
+	io(stored);
+	if (stored != value){
+		cout << "ERROR:: checkpoint " << what << " (" << stored << ") does not match the simulator (" << value << ")!\n";
+		exit(-1);
+	}
+}
+
+void Checkpoint_Stream::align(size_t boundary){
+	size_t padding = (boundary - position % boundary) % boundary;
+	if (saving){
+		for (size_t i=0; i<padding; i++)
+			if (fputc(0, file) == EOF) failed = true;
+		position += padding;
+	} else {
+		map(padding);
+	}
+}
+
+const unsigned char *Checkpoint_Stream::map(size_t n){
+	if (n > size - position){
+		cout << "ERROR:: truncated checkpoint!\n";
+		exit(-1);
+	}
+	const unsigned char *bytes = data + position;
+	position += n;
+	return bytes;
+}
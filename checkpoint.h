@@ -0,0 +1,83 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include "sim_ooo.h"
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+/* Simulator checkpoints (see sim_ooo::save_checkpoint and sim_ooo::load_checkpoint).
+   A checkpoint file holds, in host byte order:
+   - the CHECKPOINT_MAGIC string and the format version (CHECKPOINT_VERSION);
+   - flags (CHECKPOINT_FULL if the microarchitectural state is included);
+   - the program: base address and predecoded instructions;
+   - the architectural state: register files, PC and data memory size;
+   - with CHECKPOINT_FULL, the microarchitectural state: instruction window, ROB, reservation
+     stations, load/store queue, execution units, deferred releases, timing wheel, counters
+     (performance counters included) and the execution log written so far (the point the log continues from);
+   - the data memory: the number and the indexes of the pages written (see data_memory.h), then
+     those pages, aligned to CHECKPOINT_PAGE_SIZE in the file.
+   Pointers into instruction memory are stored as instruction indexes. A checkpoint is restored
+   from a read-only mapping of the file: the state is copied out of it, the memory pages with a
+   single copy each. */
+
+#define CHECKPOINT_MAGIC "OOOCKPT"
+#define CHECKPOINT_VERSION 3
+
+//the checkpoint includes the microarchitectural state
+#define CHECKPOINT_FULL 0x1
+
+//size of the data memory pages in the file
+#define CHECKPOINT_PAGE_SIZE MEMORY_PAGE_SIZE
+
+/* Checkpoint file being written or read: every field of the state goes through the same io
+   call in both directions, so saving and loading cannot drift apart. */
+class Checkpoint_Stream{
+public:
+	bool saving;
+	string filename;
+	FILE *file;                          //file written (saving)
+	bool failed;                         //a write to the file failed (saving)
+	unsigned char *data;                 //file mapped in memory (loading)
+	size_t size;                         //size of the mapped file
+	size_t position;                     //bytes written or read so far
+	const instruction_t *instr_memory;   //instruction memory the instruction pointers point into
+	unsigned instr_memory_size;
+
+	//creates the file and writes the header (saving), or maps the file and checks its header
+	Checkpoint_Stream(const char *filename, bool saving);
+
+	//closes or unmaps the file
+	~Checkpoint_Stream();
+
+	//closes the file written, and reports a failed save (any write or the close failed)
+	void close();
+
+	//writes or reads n bytes
+	void io_bytes(void *buffer, size_t n);
+
+	template <typename T> void io(T &value){
+		io_bytes(&value, sizeof value);
+	}
+
+	template <typename T> void io_array(T *values, size_t n){
+		if (n > 0) io_bytes(values, n * sizeof(T));
+	}
+
+	void io_string(string &text);
+
+	//writes or reads a pointer into instruction memory (NULL allowed)
+	void io_instr(const instruction_t *&instr);
+
+	//writes a size of the simulator, or checks that the one read matches it
+	void check(unsigned value, const char *what);
+
+	//pads (saving) or skips (loading) up to a multiple of "boundary" bytes
+	void align(size_t boundary);
+
+	//returns the next n bytes of the mapped file and skips them (loading)
+	const unsigned char *map(size_t n);
+};
+
+#endif /*CHECKPOINT_H_*/
@@ -0,0 +1,135 @@
+#include "commit_log.h"
+#include <stdlib.h>
+#include <chrono>
+#include <cstring>
+
+Log_Writer::Log_Writer(const char *filename, unsigned capacity){
+	this->filename = filename;
+	file = fopen(filename, "wb");
+	if (file == NULL){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), file);
+	this->capacity = 1;
+	while (this->capacity < capacity) this->capacity <<= 1;
+	records = new log_record_t[this->capacity];
+	head.store(0);
+	tail.store(0);
+	closing.store(false);
+	last_issue = 0;
+	writer = thread(&Log_Writer::drain, this);
+}
+
+Log_Writer::~Log_Writer(){
+	closing.store(true, memory_order_release);
+	writer.join();
+	fclose(file);
+	delete [] records;
+}
+
+//splits a 64-bit field into the record field and its upper half (UNDEFINED in both if not reached)
+static inline void split(unsigned long long value, bool reached, unsigned *low, unsigned *high){
+	*low = reached ? (unsigned)value : UNDEFINED;
+	*high = reached ? (unsigned)(value >> 32) : UNDEFINED;
+}
+
+void Log_Writer::append(const instr_window_entry_t &entry){
+	bool issued = (entry.issue != UNDEFINED_CYCLE);
+	unsigned long long base = issued ? entry.issue : 0;
+	unsigned long long stages[3] = {entry.exe, entry.wr, entry.commit};
+
+	log_record_t record;
+	log_record_t upper;
+	record.pc = entry.pc;
+	upper.pc = LOG_WIDE;
+	split(entry.issue - last_issue, issued, &record.issue, &upper.issue);
+	bool wide = issued && (entry.issue - last_issue >= UNDEFINED);
+	unsigned *fields[3] = {&record.exe, &record.wr, &record.commit};
+	unsigned *upper_fields[3] = {&upper.exe, &upper.wr, &upper.commit};
+	for (unsigned s=0; s<3; s++){
+		bool reached = (stages[s] != UNDEFINED_CYCLE);
+		split(stages[s] - base, reached, fields[s], upper_fields[s]);
+		if (reached && (stages[s] - base >= UNDEFINED)) wide = true;
+	}
+	if (wide){
+		//the issue cycle of a wide record is absolute
+		split(entry.issue, issued, &record.issue, &upper.issue);
+		push(upper);
+	}
+	push(record);
+	if (issued) last_issue = entry.issue;
+}
+
+void Log_Writer::push(const log_record_t &record){
+	unsigned long long position = head.load(memory_order_relaxed);
+	while (position - tail.load(memory_order_acquire) >= capacity) this_thread::yield();
+	records[position & (capacity-1)] = record;
+	head.store(position+1, memory_order_release);
+}
+
+void Log_Writer::flush(){
+	while (tail.load(memory_order_acquire) != head.load(memory_order_relaxed)) this_thread::yield();
+}
+
+//writer thread: moves the queued records to the file until the writer is closed
+void Log_Writer::drain(){
+	while (true){
+		bool last = closing.load(memory_order_acquire);
+		unsigned long long first = tail.load(memory_order_relaxed);
+		unsigned long long end = head.load(memory_order_acquire);
+		if (first == end){
+			if (last) break;
+			this_thread::sleep_for(chrono::microseconds(100));
+			continue;
+		}
+		//the queued records are at most two contiguous runs of the ring
+		unsigned start = first & (capacity-1);
+		unsigned long long count = end - first;
+		unsigned long long run = (count < capacity - start) ? count : capacity - start;
+		fwrite(records + start, sizeof(log_record_t), run, file);
+		if (count > run) fwrite(records, sizeof(log_record_t), count - run, file);
+		fflush(file);
+		tail.store(end, memory_order_release);
+	}
+}
+
+//joins a record field and its upper half into a 64-bit value (UNDEFINED_CYCLE if not reached)
+static inline unsigned long long join(unsigned low, unsigned high, bool wide){
+	if (wide) return (high == UNDEFINED) ? UNDEFINED_CYCLE : (((unsigned long long)high << 32) | low);
+	return (low == UNDEFINED) ? UNDEFINED_CYCLE : low;
+}
+
+bool decode_log(istream &in, ostream &out, bool header){
+	char magic[sizeof(LOG_MAGIC)];
+	if (!in.read(magic, sizeof magic) || memcmp(magic, LOG_MAGIC, sizeof magic)) return false;
+	if (header) print_log_header(out);
+
+	unsigned long long last_issue = 0;
+	log_record_t upper = {0, 0, 0, 0, 0};
+	bool wide = false;
+	log_record_t record;
+	while (in.read((char *)&record, sizeof record)){
+		if (record.pc == LOG_WIDE){
+			upper = record;
+			wide = true;
+			continue;
+		}
+		instr_window_entry_t entry;
+		entry.pc = record.pc;
+		unsigned long long issue = join(record.issue, upper.issue, wide);
+		bool issued = (issue != UNDEFINED_CYCLE);
+		entry.issue = (issued && !wide) ? last_issue + issue : issue;
+		unsigned long long base = issued ? entry.issue : 0;
+		unsigned long long exe = join(record.exe, upper.exe, wide);
+		unsigned long long wr = join(record.wr, upper.wr, wide);
+		unsigned long long commit = join(record.commit, upper.commit, wide);
+		entry.exe = (exe == UNDEFINED_CYCLE) ? UNDEFINED_CYCLE : base + exe;
+		entry.wr = (wr == UNDEFINED_CYCLE) ? UNDEFINED_CYCLE : base + wr;
+		entry.commit = (commit == UNDEFINED_CYCLE) ? UNDEFINED_CYCLE : base + commit;
+		if (issued) last_issue = entry.issue;
+		wide = false;
+		print_log_entry(out, entry);
+	}
+	return true;
+}
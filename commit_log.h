@@ -0,0 +1,74 @@
+#ifndef COMMIT_LOG_H_
+#define COMMIT_LOG_H_
+
+#include "sim_ooo.h"
+#include <atomic>
+#include <thread>
+#include <iostream>
+
+using namespace std;
+
+/* Binary execution log.
+   Instead of formatting every logged instruction into the text log, a simulator with a binary
+   log (see sim_ooo::set_log_file) encodes it into a fixed-size record and pushes it into a
+   lock-free single-producer, single-consumer ring. A writer thread drains the ring to the log
+   file, so the memory used is the ring, however long the run. decode_log turns the file back
+   into the text log, as print_log would have printed it.
+
+   File format: the LOG_MAGIC string, then one log_record_t per logged instruction (host byte
+   order). The issue cycle is stored as the distance from the issue cycle of the previous
+   record, the other cycles as the distance from the issue cycle; UNDEFINED marks a stage the
+   instruction did not reach. When a distance does not fit in 32 bits the record is preceded by
+   a LOG_WIDE record with the upper 32 bits of each field, the issue cycle being absolute. */
+
+#define LOG_MAGIC "OOOLOG1"
+
+//pc of the record holding the upper halves of the next record (never a PC: not word aligned)
+#define LOG_WIDE 0xFFFFFFFE
+
+//default number of records in the ring of a log writer
+#define LOG_RING_SIZE 65536
+
+//binary log record
+typedef struct{
+	unsigned pc;
+	unsigned issue;  // issue cycle - issue cycle of the previous record
+	unsigned exe;    // clock cycles from issue to execution
+	unsigned wr;     // clock cycles from issue to write result
+	unsigned commit; // clock cycles from issue to commit
+} log_record_t;
+
+class Log_Writer{
+public:
+	string filename;
+	FILE *file;
+	unsigned capacity;                  //number of records (power of 2)
+	log_record_t *records;
+	atomic<unsigned long long> head;    //records pushed
+	atomic<unsigned long long> tail;    //records written to the file
+	atomic<bool> closing;
+	unsigned long long last_issue;      //issue cycle the next record is relative to (used by the simulator only)
+	thread writer;
+
+	//creates the log file and starts the writer thread
+	Log_Writer(const char *filename, unsigned capacity=LOG_RING_SIZE);
+
+	//writes the remaining records and closes the file
+	~Log_Writer();
+
+	//encodes an instruction window entry and queues it for writing (waits if the ring is full)
+	void append(const instr_window_entry_t &entry);
+
+	//waits until every record appended is in the file
+	void flush();
+
+private:
+	void push(const log_record_t &record);
+	void drain();
+};
+
+//decodes a binary log into the text log (with its header if "header" is set); returns false if
+//the stream is not a binary log
+bool decode_log(istream &in, ostream &out, bool header=true);
+
+#endif /*COMMIT_LOG_H_*/
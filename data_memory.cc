@@ -0,0 +1,210 @@
+#include "data_memory.h"
+#include <stdlib.h>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+
+/* =============================================================
+
+   Page allocation
+
+   ============================================================= */
+
+//pages are carved out of huge-page arenas (see Data_Memory::set_huge_pages)
+static atomic<bool> huge_pages(false);
+
+//pages of the arenas not in use, and the rest of the last arena mapped
+static mutex arena_lock;
+static vector<memory_page_t *> free_arena_pages;
+static unsigned char *arena_next = NULL;
+static unsigned char *arena_end = NULL;
+
+//returns a new page, with one reference
+static memory_page_t *allocate_page(){
+	memory_page_t *page = NULL;
+	if (huge_pages.load()){
+		lock_guard<mutex> guard(arena_lock);
+		if (!free_arena_pages.empty()){
+			page = free_arena_pages.back();
+			free_arena_pages.pop_back();
+		} else {
+			if (arena_next == NULL || arena_end - arena_next < (long)sizeof(memory_page_t)){
+				//the arena is aligned to its size, so that the system can back it with huge pages
+				unsigned char *arena = (unsigned char *)mmap(NULL, 2*MEMORY_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (arena != MAP_FAILED){
+					unsigned char *aligned = (unsigned char *)(((unsigned long)arena + MEMORY_ARENA_SIZE - 1) & ~(unsigned long)(MEMORY_ARENA_SIZE - 1));
+					if (aligned > arena) munmap(arena, aligned - arena);
+					munmap(aligned + MEMORY_ARENA_SIZE, arena + 2*MEMORY_ARENA_SIZE - (aligned + MEMORY_ARENA_SIZE));
+#ifdef MADV_HUGEPAGE
+					madvise(aligned, MEMORY_ARENA_SIZE, MADV_HUGEPAGE);
+#endif
+					arena_next = aligned;
+					arena_end = aligned + MEMORY_ARENA_SIZE;
+				}
+			}
+			if (arena_next != NULL && arena_end - arena_next >= (long)sizeof(memory_page_t)){
+				page = new (arena_next) memory_page_t;
+				page->in_arena = true;
+				arena_next += (sizeof(memory_page_t) + 63) & ~(size_t)63;
+			}
+		}
+	}
+	if (page == NULL){
+		page = new memory_page_t;
+		page->in_arena = false;
+	}
+	page->references.store(1);
+	page->dirty = true;
+	return page;
+}
+
+//frees a page nobody references any more
+static void free_page(memory_page_t *page){
+	if (page->in_arena){
+		lock_guard<mutex> guard(arena_lock);
+		free_arena_pages.push_back(page);
+	} else {
+		delete page;
+	}
+}
+
+void Data_Memory::set_huge_pages(bool enable){
+	huge_pages.store(enable);
+}
+
+/* =============================================================
+
+   Data memory
+
+   ============================================================= */
+
+Data_Memory::Data_Memory(){
+	size = 0;
+	num_pages = 0;
+	pages = NULL;
+}
+
+Data_Memory::~Data_Memory(){
+	clear();
+	free(pages);
+}
+
+void Data_Memory::init(unsigned size){
+	clear();
+	free(pages);
+	this->size = size;
+	num_pages = (unsigned)(((unsigned long long)size + MEMORY_PAGE_SIZE - 1) >> MEMORY_PAGE_BITS);
+	//a large zeroed allocation is mapped lazily by the system, so an untouched table costs nothing
+	pages = (memory_page_t **)calloc(num_pages > 0 ? num_pages : 1, sizeof(memory_page_t *));
+}
+
+void Data_Memory::copy(const Data_Memory &other){
+	init(other.size);
+	touched = other.touched;
+	for (unsigned i=0; i<touched.size(); i++){
+		memory_page_t *page = other.pages[touched[i]];
+		page->references++;
+		pages[touched[i]] = page;
+	}
+}
+
+//drops the reference of the memory to a page, and frees the page if it was the last one. The
+//decrement releases the reads of the page to the holder that will find itself alone with it
+void Data_Memory::release(unsigned page){
+	if (pages[page]->references.fetch_sub(1, memory_order_acq_rel) == 1) free_page(pages[page]);
+	pages[page] = NULL;
+}
+
+void Data_Memory::clear(){
+	for (unsigned i=0; i<touched.size(); i++) release(touched[i]);
+	touched.clear();
+}
+
+void Data_Memory::reset(){
+	unsigned kept = 0;
+	for (unsigned i=0; i<touched.size(); i++){
+		memory_page_t *page = pages[touched[i]];
+		if (page->references.load(memory_order_acquire) != 1){
+			release(touched[i]);
+			continue;
+		}
+		if (page->dirty){
+			memset(page->bytes, 0xFF, MEMORY_PAGE_SIZE);
+			page->dirty = false;
+		}
+		touched[kept++] = touched[i];
+	}
+	touched.resize(kept);
+}
+
+const unsigned char *Data_Memory::read_page(unsigned page) const{
+	return (pages[page] == NULL) ? NULL : pages[page]->bytes;
+}
+
+unsigned char *Data_Memory::write_page(unsigned page){
+	memory_page_t *current = pages[page];
+	if (current != NULL && current->references.load(memory_order_acquire) == 1){
+		current->dirty = true;
+		return current->bytes;
+	}
+	memory_page_t *copy = allocate_page();
+	if (current == NULL){
+		memset(copy->bytes, 0xFF, MEMORY_PAGE_SIZE);
+		touched.push_back(page);
+	} else {
+		memcpy(copy->bytes, current->bytes, MEMORY_PAGE_SIZE);
+		release(page);
+	}
+	pages[page] = copy;
+	return copy->bytes;
+}
+
+unsigned char Data_Memory::load_byte(unsigned address) const{
+	if (address >= size) return 0xFF;
+	const unsigned char *page = read_page(address >> MEMORY_PAGE_BITS);
+	return (page == NULL) ? 0xFF : page[address & (MEMORY_PAGE_SIZE - 1)];
+}
+
+unsigned Data_Memory::load_word_slow(unsigned address) const{
+	unsigned value = 0;
+	for (unsigned b=0; b<4; b++) value |= (unsigned)load_byte(address + b) << (8*b);
+	return value;
+}
+
+void Data_Memory::store_word_slow(unsigned address, unsigned value){
+	for (unsigned b=0; b<4; b++){
+		unsigned byte_address = address + b;
+		if (byte_address >= size) continue;
+		unsigned char *page = write_page(byte_address >> MEMORY_PAGE_BITS);
+		page[byte_address & (MEMORY_PAGE_SIZE - 1)] = (value >> (8*b)) & 0xFF;
+	}
+}
+
+void Data_Memory::store_bytes(unsigned address, const unsigned char *bytes, unsigned length){
+	while (length > 0){
+		unsigned page = address >> MEMORY_PAGE_BITS;
+		unsigned offset = address & (MEMORY_PAGE_SIZE - 1);
+		unsigned chunk = (length < MEMORY_PAGE_SIZE - offset) ? length : MEMORY_PAGE_SIZE - offset;
+		unsigned blank = 0;
+		if (pages[page] == NULL){
+			while (blank < chunk && bytes[blank] == 0xFF) blank++;
+		}
+		if (blank < chunk) memcpy(write_page(page) + offset, bytes, chunk);
+		address += chunk;
+		bytes += chunk;
+		length -= chunk;
+	}
+}
+
+bool Data_Memory::equal(const Data_Memory &other) const{
+	if (size != other.size) return false;
+	unsigned char blank[MEMORY_PAGE_SIZE];
+	memset(blank, 0xFF, MEMORY_PAGE_SIZE);
+	for (unsigned p=0; p<num_pages; p++){
+		const unsigned char *a = read_page(p);
+		const unsigned char *b = other.read_page(p);
+		if (a == b) continue;
+		if (memcmp(a ? a : blank, b ? b : blank, MEMORY_PAGE_SIZE)) return false;
+	}
+	return true;
+}
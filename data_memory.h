@@ -0,0 +1,122 @@
+#ifndef DATA_MEMORY_H_
+#define DATA_MEMORY_H_
+
+#include <atomic>
+#include <vector>
+#include <string.h>
+
+using namespace std;
+
+/* Paged data memory.
+   The memory is split into MEMORY_PAGE_SIZE-byte pages, allocated on their first write: a page
+   never written reads as 0xFF (the reset value), so a large memory only costs the pages the
+   program touches. The pages are reference counted and shared copy-on-write between copies of
+   a memory: copying a memory (see sim_ooo::clone) shares all its pages, and the first write to
+   a shared page gives the writer a private duplicate. The copies can run on different threads.
+
+   Resetting a memory re-fills only the private pages written since the previous reset, and
+   keeps them allocated for the next run. With set_huge_pages, the pages are carved out of
+   MEMORY_ARENA_SIZE arenas backed by transparent huge pages (where the system provides them),
+   which saves TLB misses on programs touching many pages. The word accessors handle the common
+   case (an aligned word, on a page that is allocated and, for stores, private and dirty) inline,
+   and leave the rest to the byte-by-byte slow path. */
+
+#define MEMORY_PAGE_BITS 12
+#define MEMORY_PAGE_SIZE (1u << MEMORY_PAGE_BITS)
+
+//size of the huge-page arenas the pages are carved out of (see set_huge_pages)
+#define MEMORY_ARENA_SIZE (2u << 20)
+
+typedef struct{
+	unsigned char bytes[MEMORY_PAGE_SIZE];
+	atomic<unsigned> references;  // memories holding the page
+	bool dirty;                   // written since the last reset (meaningful on private pages)
+	bool in_arena;                // carved out of a huge-page arena (recycled, never deleted)
+} memory_page_t;
+
+class Data_Memory{
+public:
+	unsigned size;              //bytes
+	unsigned num_pages;
+	memory_page_t **pages;      //page table: NULL for the pages never written
+	vector<unsigned> touched;   //pages allocated (the non-NULL entries of the table)
+
+	Data_Memory();
+	~Data_Memory();
+
+	//sizes the memory to "size" bytes, all 0xFF
+	void init(unsigned size);
+
+	//makes the memory a copy of "other", sharing its pages: O(pages touched), as the page table
+	//is allocated zeroed and only its non-NULL entries are copied
+	void copy(const Data_Memory &other);
+
+	//releases every page: the memory reads as 0xFF again
+	void clear();
+
+	//brings the memory back to all 0xFF: the private dirty pages are re-filled and kept, the
+	//shared ones released
+	void reset();
+
+	//returns the bytes of a page, NULL if the page was never written
+	const unsigned char *read_page(unsigned page) const;
+
+	//returns the bytes of a page for writing: a page never written is allocated (all 0xFF), a
+	//shared one is duplicated
+	unsigned char *write_page(unsigned page);
+
+	//reads and writes little-endian words; the bytes beyond the end of the memory read as 0xFF
+	//and are not written
+	unsigned load_word(unsigned address) const;
+	void store_word(unsigned address, unsigned value);
+	unsigned char load_byte(unsigned address) const;
+
+	//copies "length" bytes to the memory from "address" (which must hold them), page by page: the
+	//pieces left at 0xFF do not allocate a page never written
+	void store_bytes(unsigned address, const unsigned char *bytes, unsigned length);
+
+	//true if both memories have the same size and content
+	bool equal(const Data_Memory &other) const;
+
+	//from now on, allocates the pages of every memory out of huge-page arenas (enable), or
+	//with new (the pages already allocated stay where they are)
+	static void set_huge_pages(bool enable);
+
+private:
+	void release(unsigned page);
+	unsigned load_word_slow(unsigned address) const;
+	void store_word_slow(unsigned address, unsigned value);
+};
+
+//the fast paths copy the word as is: the data memory is little-endian, like the host
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define MEMORY_FAST_WORDS 1
+#else
+#define MEMORY_FAST_WORDS 0
+#endif
+
+inline unsigned Data_Memory::load_word(unsigned address) const{
+	if (MEMORY_FAST_WORDS && (address & 3) == 0 && address < (size & ~3u)){
+		const memory_page_t *page = pages[address >> MEMORY_PAGE_BITS];
+		if (page == NULL) return 0xFFFFFFFF;
+		unsigned value;
+		memcpy(&value, page->bytes + (address & (MEMORY_PAGE_SIZE - 1)), sizeof value);
+		return value;
+	}
+	return load_word_slow(address);
+}
+
+inline void Data_Memory::store_word(unsigned address, unsigned value){
+	if (MEMORY_FAST_WORDS && (address & 3) == 0 && address < (size & ~3u)){
+		memory_page_t *page = pages[address >> MEMORY_PAGE_BITS];
+		//acquire, paired with the release of the last other reference (see release): the copies
+		//the other holders made of the page happen before it is written in place
+		if (page != NULL && page->dirty && page->references.load(memory_order_acquire) == 1){
+			memcpy(page->bytes + (address & (MEMORY_PAGE_SIZE - 1)), &value, sizeof value);
+			return;
+		}
+	}
+	store_word_slow(address, value);
+}
+
+#endif /*DATA_MEMORY_H_*/
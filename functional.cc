@@ -0,0 +1,248 @@
+#include "functional.h"
+#include <thread>
+#include <cstring>
+#include <iostream>
+
+/* =============================================================
+
+   TRACE RING
+
+   ============================================================= */
+
+Trace_Ring::Trace_Ring(unsigned window, unsigned num_consumers, unsigned capacity){
+	this->capacity = 1;
+	while (this->capacity < capacity) this->capacity <<= 1;
+	this->window = window;
+	this->num_consumers = num_consumers;
+	records = new trace_record_t[this->capacity];
+	written.store(0);
+	closed.store(false);
+	readers = new trace_reader_t[num_consumers];
+	for (unsigned c=0; c<num_consumers; c++){
+		readers[c].read.store(0);
+		readers[c].available = 0;
+	}
+	free_until = 0;
+}
+
+Trace_Ring::~Trace_Ring(){
+	delete [] records;
+	delete [] readers;
+}
+
+bool Trace_Ring::push(const trace_record_t &record){
+	unsigned long long position = written.load(memory_order_relaxed);
+	while (position >= free_until){
+		//the slowest consumer still attached decides how far the ring can be written
+		unsigned long long slowest = TRACE_DETACHED;
+		for (unsigned c=0; c<num_consumers; c++){
+			unsigned long long read = readers[c].read.load(memory_order_acquire);
+			if (read < slowest) slowest = read;
+		}
+		if (slowest == TRACE_DETACHED) return false;
+		free_until = slowest + capacity;
+		if (position < free_until) break;
+		this_thread::yield();
+	}
+	records[position & (capacity-1)] = record;
+	written.store(position+1, memory_order_release);
+	return true;
+}
+
+void Trace_Ring::close(){
+	closed.store(true, memory_order_release);
+}
+
+//waits until "count" records have been written; returns false if the trace ends before
+bool Trace_Ring::wait_for(trace_reader_t &reader, unsigned long long count){
+	while (reader.available < count){
+		bool last = closed.load(memory_order_acquire);
+		reader.available = written.load(memory_order_acquire);
+		if (reader.available >= count) break;
+		if (last) return false;
+		this_thread::yield();
+	}
+	return true;
+}
+
+bool Trace_Ring::pop(unsigned consumer, trace_record_t *record){
+	trace_reader_t &reader = readers[consumer];
+	unsigned long long position = reader.read.load(memory_order_relaxed);
+	if (!wait_for(reader, position+1)) return false;
+	*record = records[position & (capacity-1)];
+	reader.read.store(position+1, memory_order_release);
+	return true;
+}
+
+void Trace_Ring::skip(unsigned consumer, unsigned n){
+	trace_reader_t &reader = readers[consumer];
+	unsigned long long position = reader.read.load(memory_order_relaxed);
+	//the records must have been written before their slots are handed back to the producer
+	wait_for(reader, position+n);
+	reader.read.store(position+n, memory_order_release);
+}
+
+void Trace_Ring::detach(unsigned consumer){
+	readers[consumer].read.store(TRACE_DETACHED, memory_order_release);
+}
+
+/* =============================================================
+
+   FUNCTIONAL EXECUTOR
+
+   ============================================================= */
+
+Functional_Executor::Functional_Executor(unsigned mem_size){
+	data_memory_size = mem_size;
+	data_memory.init(data_memory_size);
+	reset();
+}
+
+void Functional_Executor::reset(){
+	for (unsigned i=0; i<NUM_GP_REGISTERS; i++){
+		int_registers[i] = UNDEFINED;
+		fp_registers[i] = UNDEFINED;
+	}
+	data_memory.reset();
+	instr_memory = NULL;
+	instr_memory_size = 0;
+	instr_base_address = 0;
+	PC = 0;
+	instructions_executed = 0;
+}
+
+void Functional_Executor::load_program(const program_image_t &image){
+	instr_memory = &image.instructions[0];
+	instr_memory_size = image.instructions.size();
+	instr_base_address = image.base_address;
+	PC = image.base_address;
+	for (unsigned i=0; i<image.data.size(); i++){
+		const data_segment_t &segment = image.data[i];
+		if (segment.address > data_memory_size || segment.bytes.size() > data_memory_size - segment.address){
+			cout << "ERROR:: data segment at 0x" << hex << segment.address << " does not fit in the data memory!\n";
+			exit(-1);
+		}
+		data_memory.store_bytes(segment.address, &segment.bytes[0], segment.bytes.size());
+	}
+}
+
+void Functional_Executor::set_int_register(unsigned reg, int value){
+	int_registers[reg] = value;
+}
+
+void Functional_Executor::set_fp_register(unsigned reg, float value){
+	memcpy(&fp_registers[reg], &value, sizeof(unsigned));
+}
+
+void Functional_Executor::write_memory(unsigned address, unsigned value){
+	store(address, value, NULL);
+}
+
+bool Functional_Executor::isValidPC(unsigned pc){
+	return ((pc >= instr_base_address) && ((pc - instr_base_address) / 4 < instr_memory_size));
+}
+
+//reads a little-endian word; the bytes written on the wrong path are looked up in "overlay" first.
+//Addresses outside the data memory read as UNDEFINED
+unsigned Functional_Executor::load(unsigned address, const map<unsigned, unsigned char> *overlay){
+	if (data_memory_size < 4 || address > data_memory_size - 4) return UNDEFINED;
+	if (overlay == NULL || overlay->empty()) return data_memory.load_word(address);
+	unsigned value = 0;
+	for (unsigned b=0; b<4; b++){
+		unsigned char byte = data_memory.load_byte(address+b);
+		map<unsigned, unsigned char>::const_iterator search = overlay->find(address+b);
+		if (search != overlay->end()) byte = search->second;
+		value |= (unsigned)byte << (8*b);
+	}
+	return value;
+}
+
+//writes a little-endian word to memory, or to "overlay" on the wrong path.
+//Stores outside the data memory are dropped
+void Functional_Executor::store(unsigned address, unsigned value, map<unsigned, unsigned char> *overlay){
+	if (data_memory_size < 4 || address > data_memory_size - 4) return;
+	if (overlay == NULL){
+		data_memory.store_word(address, value);
+		return;
+	}
+	for (unsigned b=0; b<4; b++) (*overlay)[address+b] = (value >> (8*b)) & 0xFF;
+}
+
+//executes the instruction at "pc" on the given registers and fills in its trace record
+void Functional_Executor::execute(unsigned pc, unsigned *int_regs, unsigned *fp_regs, map<unsigned, unsigned char> *overlay, trace_record_t *record){
+	const instruction_t &instr = instr_memory[(pc - instr_base_address) / 4];
+	unsigned *regs = (instr.flags & INSTR_FP) ? fp_regs : int_regs;
+	record->pc = pc;
+	record->address = UNDEFINED;
+	record->wrong_path = 0;
+	switch(instr.opcode){
+		case LW:
+		case LWS:
+			record->address = int_regs[instr.src1] + instr.immediate;
+			record->value = load(record->address, overlay);
+			regs[instr.dest] = record->value;
+			break;
+		case SW:
+		case SWS:
+			record->address = int_regs[instr.src2] + instr.immediate;
+			record->value = regs[instr.src1];
+			store(record->address, record->value, overlay);
+			break;
+		case JUMP:
+			record->value = alu(JUMP, UNDEFINED, UNDEFINED, instr.immediate, pc);
+			break;
+		case BEQZ:
+		case BNEZ:
+		case BLTZ:
+		case BGTZ:
+		case BLEZ:
+		case BGEZ:
+			record->value = alu(instr.opcode, int_regs[instr.src1], UNDEFINED, instr.immediate, pc);
+			break;
+		case ADDI:
+		case SUBI:
+			record->value = alu(instr.opcode, int_regs[instr.src1], instr.immediate, UNDEFINED, pc);
+			regs[instr.dest] = record->value;
+			break;
+		default:
+			record->value = alu(instr.opcode, regs[instr.src1], regs[instr.src2], UNDEFINED, pc);
+			regs[instr.dest] = record->value;
+			break;
+	}
+}
+
+//executes up to "length" instructions from "pc" in instruction memory order, without changing
+//the architectural state, as the pipeline does after a taken branch until the branch commits
+void Functional_Executor::wrong_path(unsigned pc, unsigned length, vector<trace_record_t> &records){
+	unsigned int_regs[NUM_GP_REGISTERS];
+	unsigned fp_regs[NUM_GP_REGISTERS];
+	memcpy(int_regs, int_registers, sizeof int_regs);
+	memcpy(fp_regs, fp_registers, sizeof fp_regs);
+	map<unsigned, unsigned char> overlay;
+	records.clear();
+	while ((records.size() < length) && isValidPC(pc) && (instr_memory[(pc - instr_base_address) / 4].opcode != EOP)){
+		trace_record_t record;
+		execute(pc, int_regs, fp_regs, &overlay, &record);
+		records.push_back(record);
+		pc += 4;
+	}
+}
+
+void Functional_Executor::run(Trace_Ring *ring){
+	vector<trace_record_t> records;
+	while (isValidPC(PC) && (instr_memory[(PC - instr_base_address) / 4].opcode != EOP)){
+		const instruction_t &instr = instr_memory[(PC - instr_base_address) / 4];
+		trace_record_t record;
+		execute(PC, int_registers, fp_registers, NULL, &record);
+		unsigned next_pc = (instr.flags & INSTR_BRANCH) ? record.value : PC + 4;
+		records.clear();
+		if (next_pc != PC + 4) wrong_path(PC + 4, ring->window, records);
+		record.wrong_path = records.size();
+		bool attached = ring->push(record);
+		for (unsigned i=0; attached && i<records.size(); i++) attached = ring->push(records[i]);
+		if (!attached) break;
+		instructions_executed++;
+		PC = next_pc;
+	}
+	ring->close();
+}
@@ -0,0 +1,111 @@
+#ifndef FUNCTIONAL_H_
+#define FUNCTIONAL_H_
+
+#include "sim_ooo.h"
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+/* Functional-first decoupled mode.
+   A functional executor runs the program once, in program order, and writes its instruction
+   stream to a trace ring: one record per instruction with its result and effective address.
+   Any number of timing-only simulators (see sim_ooo::attach_trace) read the ring concurrently,
+   each on its own thread, and take the values of their instructions from it instead of
+   computing them.
+
+   The pipeline predicts every branch not taken and keeps issuing down the fall-through path
+   until the branch commits, so after each taken branch the trace also holds the "wrong path":
+   the instructions following the branch in instruction memory, executed on a scratch copy of
+   the state, up to the largest number of instructions a consumer can issue before the branch
+   commits (its ROB size - 1). A consumer skips the wrong-path records it did not issue when
+   it squashes. */
+
+//default number of records in a trace ring
+#define TRACE_RING_SIZE 4096
+
+//read position of a consumer that has left the ring
+#define TRACE_DETACHED (~0ULL)
+
+//read position of a consumer, on its own cache line
+struct alignas(64) trace_reader_t{
+	atomic<unsigned long long> read; //records consumed (TRACE_DETACHED once the consumer has left)
+	unsigned long long available;    //records known to be written (used by the consumer only)
+};
+
+/* Single-producer, multiple-consumer ring of trace records: the producer waits for the slowest
+   attached consumer, the consumers wait for the producer. Every consumer reads every record. */
+class Trace_Ring{
+public:
+	unsigned capacity;                   //number of records (power of 2)
+	unsigned window;                     //wrong-path records written after each taken branch (at most)
+	unsigned num_consumers;
+	trace_record_t *records;
+	atomic<unsigned long long> written;  //records pushed so far
+	atomic<bool> closed;                 //set once the last record has been pushed
+	trace_reader_t *readers;
+	unsigned long long free_until;       //position up to which the ring can be written (used by the producer only)
+
+	Trace_Ring(unsigned window, unsigned num_consumers, unsigned capacity=TRACE_RING_SIZE);
+	~Trace_Ring();
+
+	//appends a record; returns false (without waiting) if all the consumers have left
+	bool push(const trace_record_t &record);
+
+	//marks the end of the trace
+	void close();
+
+	//reads the next record of a consumer; returns false at the end of the trace
+	bool pop(unsigned consumer, trace_record_t *record);
+
+	//drops the next n records of a consumer
+	void skip(unsigned consumer, unsigned n);
+
+	//removes a consumer: the producer does not wait for it anymore
+	void detach(unsigned consumer);
+
+private:
+	bool wait_for(trace_reader_t &reader, unsigned long long count);
+};
+
+/* Functional executor: architectural state only (registers and data memory), one instruction
+   at a time. The results are those of the timing pipeline, as both use alu(). */
+class Functional_Executor{
+public:
+	unsigned int_registers[NUM_GP_REGISTERS];
+	unsigned fp_registers[NUM_GP_REGISTERS];
+	Data_Memory data_memory;    //paged, see data_memory.h
+	unsigned data_memory_size;
+	const instruction_t *instr_memory;
+	unsigned instr_memory_size;
+	unsigned instr_base_address;
+	unsigned PC;
+	unsigned long long instructions_executed;
+
+	//registers are initialized to UNDEFINED and data memory to all 0xFF, as in the simulator
+	Functional_Executor(unsigned mem_size);
+
+	//brings the registers and the data memory back to their initial values, keeping the memory
+	//pages written so far allocated for the next program (see Data_Memory::reset)
+	void reset();
+
+	//loads a parsed program (shared, not copied)
+	void load_program(const program_image_t &image);
+
+	void set_int_register(unsigned reg, int value);
+	void set_fp_register(unsigned reg, float value);
+	void write_memory(unsigned address, unsigned value);
+
+	//runs the program to completion, or until all the consumers have left, writing its trace
+	//to the ring (with wrong paths of ring->window instructions), then closes the ring
+	void run(Trace_Ring *ring);
+
+private:
+	bool isValidPC(unsigned pc);
+	unsigned load(unsigned address, const map<unsigned, unsigned char> *overlay);
+	void store(unsigned address, unsigned value, map<unsigned, unsigned char> *overlay);
+	void execute(unsigned pc, unsigned *int_regs, unsigned *fp_regs, map<unsigned, unsigned char> *overlay, trace_record_t *record);
+	void wrong_path(unsigned pc, unsigned length, vector<trace_record_t> &records);
+};
+
+#endif /*FUNCTIONAL_H_*/
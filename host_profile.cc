@@ -0,0 +1,133 @@
+#include "host_profile.h"
+#include <iomanip>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *host_section_names[NUM_HOST_SECTIONS] = {"commit", "write_result", "execute", "issue", "log", "other"};
+static const char *host_counter_names[NUM_HOST_COUNTERS] = {"instructions", "cache_misses", "branch_misses"};
+
+Host_Profile::Host_Profile(bool use_counters){
+	this->use_counters = use_counters;
+	for (unsigned c=0; c<NUM_HOST_COUNTERS; c++) counter_fds[c] = -1;
+	memset(ticks, 0, sizeof ticks);
+	memset(calls, 0, sizeof calls);
+	memset(counts, 0, sizeof counts);
+	memset(last_counts, 0, sizeof last_counts);
+	current = HOST_OTHER;
+	counted = use_counters;
+	seconds = 0;
+	total_ticks = 0;
+	cycles = 0;
+	instructions = 0;
+	runs = 0;
+	start_tick = last_tick = host_ticks();
+	start_cycle = 0;
+	start_instructions = 0;
+}
+
+Host_Profile::~Host_Profile(){
+	close_counters();
+}
+
+#ifdef __linux__
+//opens a user-space hardware counter of the calling thread, in the group of "leader" (-1: new group)
+static int open_counter(unsigned long long config, int leader){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof attr;
+	attr.config = config;
+	attr.disabled = (leader < 0);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+}
+#endif
+
+void Host_Profile::start(unsigned long long cycle, unsigned long long instructions){
+	current = HOST_OTHER;
+	start_cycle = cycle;
+	start_instructions = instructions;
+	close_counters();
+#ifdef __linux__
+	//the counters follow the thread running the simulator, so they are opened for each run
+	if (use_counters){
+		unsigned long long configs[NUM_HOST_COUNTERS] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+		for (unsigned c=0; c<NUM_HOST_COUNTERS; c++){
+			counter_fds[c] = open_counter(configs[c], counter_fds[0]);
+			if (counter_fds[c] < 0){
+				close_counters();
+				break;
+			}
+		}
+		if (counter_fds[0] >= 0){
+			ioctl(counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+			memset(last_counts, 0, sizeof last_counts);
+			read_counters();
+		}
+	}
+#endif
+	if (counter_fds[0] < 0) counted = false;
+	start_time = chrono::steady_clock::now();
+	start_tick = host_ticks();
+	last_tick = start_tick;
+}
+
+void Host_Profile::read_counters(){
+	//group read: the number of counters, then their values
+	unsigned long long values[1 + NUM_HOST_COUNTERS];
+	if (read(counter_fds[0], values, sizeof values) != (ssize_t)sizeof values) return;
+	for (unsigned c=0; c<NUM_HOST_COUNTERS; c++){
+		counts[current][c] += values[1 + c] - last_counts[c];
+		last_counts[c] = values[1 + c];
+	}
+}
+
+void Host_Profile::close_counters(){
+	for (unsigned c=0; c<NUM_HOST_COUNTERS; c++){
+		if (counter_fds[c] >= 0) close(counter_fds[c]);
+		counter_fds[c] = -1;
+	}
+}
+
+void Host_Profile::stop(unsigned long long cycle, unsigned long long instructions){
+	switch_to(HOST_OTHER);
+	close_counters();
+	seconds += chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+	total_ticks += last_tick - start_tick;
+	cycles += cycle - start_cycle;
+	this->instructions += instructions - start_instructions;
+	runs++;
+}
+
+void Host_Profile::print(ostream &out){
+	unsigned long long total = total_ticks;
+	double seconds_per_tick = (total > 0) ? seconds / total : 0;
+	unsigned long long executed = instructions;
+
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	out << "HOST PROFILE" << endl;
+	out << fixed << setprecision(6) << runs << " runs, " << cycles << " cycles, " << executed << " instructions in " << seconds << " s: "
+	    << setprecision(0) << (seconds > 0 ? cycles / seconds : 0) << " cycles/s, "
+	    << setprecision(1) << (seconds > 0 ? executed / seconds / 1e3 : 0) << " KIPS" << endl;
+	out << left << setw(14) << "section" << right << setw(9) << "share" << setw(14) << "calls" << setw(12) << "ns/call";
+	if (counted) for (unsigned c=0; c<NUM_HOST_COUNTERS; c++) out << setw(16) << host_counter_names[c];
+	out << endl;
+	for (unsigned s=0; s<NUM_HOST_SECTIONS; s++){
+		out << left << setw(14) << host_section_names[s] << right << setw(8) << setprecision(1) << (total ? 100.0 * ticks[s] / total : 0) << "%"
+		    << setw(14) << calls[s] << setw(12) << (calls[s] ? 1e9 * seconds_per_tick * ticks[s] / calls[s] : 0);
+		if (counted) for (unsigned c=0; c<NUM_HOST_COUNTERS; c++) out << setw(16) << counts[s][c];
+		out << endl;
+	}
+	if (use_counters && !counted) out << "(host counters unavailable)" << endl;
+	out << endl;
+	out.flags(flags);
+	out.precision(precision);
+}
@@ -0,0 +1,116 @@
+#ifndef HOST_PROFILE_H_
+#define HOST_PROFILE_H_
+
+#include <iostream>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+/* Host-side profile of the simulator.
+   Built with -DHOST_PROFILE=1 (see the Makefile), every run() measures the host time spent in
+   each pipeline handler, in the logging path (commit_to_log) and in the rest of the loop. The
+   runs of a simulator add up, and the simulator prints the profile once, to cerr, when it is
+   deleted: the simulated cycles per host second, the host KIPS (thousands of simulated
+   instructions per host second) and the breakdown by section. With -DHOST_PROFILE=2,
+   each section also counts the host instructions, cache misses and branch misses through Linux
+   perf_event_open (where the system allows it): a counter read is a system call, so this mode
+   slows the simulator down noticeably.
+
+   The sections are exclusive: the logging done by the commit handler is charged to the logging
+   path only. Times are taken with rdtsc on x86 (steady_clock elsewhere) and converted to seconds
+   against steady_clock over the runs; the time between two runs is not counted. Without HOST_PROFILE, the HOST_PROFILE_SCOPE hooks
+   expand to nothing and no profile is allocated. */
+
+//sections of the simulator loop
+typedef enum {HOST_COMMIT, HOST_WB, HOST_EXE, HOST_ISSUE, HOST_LOG, HOST_OTHER, NUM_HOST_SECTIONS} host_section_t;
+
+//host counters read through perf_event_open (instructions, cache misses, branch misses)
+#define NUM_HOST_COUNTERS 3
+
+//host timestamp, in ticks
+inline unsigned long long host_ticks(){
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+class Host_Profile{
+public:
+	bool use_counters;                      //perf counters requested
+	int counter_fds[NUM_HOST_COUNTERS];     //perf events (the first one leads the group), -1 if not open
+	unsigned long long ticks[NUM_HOST_SECTIONS];
+	unsigned long long calls[NUM_HOST_SECTIONS];
+	unsigned long long counts[NUM_HOST_SECTIONS][NUM_HOST_COUNTERS];
+	unsigned current;                       //section running
+	unsigned long long last_tick;           //when it was entered
+	unsigned long long last_counts[NUM_HOST_COUNTERS];
+	bool counted;                           //the counters could be opened for every run
+
+	//totals of the runs
+	double seconds;
+	unsigned long long total_ticks;
+	unsigned long long cycles;
+	unsigned long long instructions;
+	unsigned long long runs;
+
+	//start of the current run
+	chrono::steady_clock::time_point start_time;
+	unsigned long long start_tick;
+	unsigned long long start_cycle;
+	unsigned long long start_instructions;
+
+	//creates an empty profile
+	Host_Profile(bool use_counters);
+	~Host_Profile();
+
+	//opens the counters at the start of a run
+	void start(unsigned long long cycle, unsigned long long instructions);
+
+	//closes the counters at the end of a run and adds it to the profile
+	void stop(unsigned long long cycle, unsigned long long instructions);
+
+	//prints the profile of all the runs
+	void print(ostream &out);
+
+	//charges the host time (and counts) since the last switch to the current section, and enters "section"
+	void switch_to(unsigned section);
+
+private:
+	void read_counters();
+	void close_counters();
+};
+
+inline void Host_Profile::switch_to(unsigned section){
+	unsigned long long now = host_ticks();
+	ticks[current] += now - last_tick;
+	last_tick = now;
+	if (counter_fds[0] >= 0) read_counters();
+	current = section;
+}
+
+//charges the host time of the enclosing block to a section, then returns to the outer one
+class Host_Scope{
+	Host_Profile &profile;
+	unsigned outer;
+public:
+	Host_Scope(Host_Profile &profile, unsigned section) : profile(profile), outer(profile.current){
+		profile.calls[section]++;
+		profile.switch_to(section);
+	}
+	~Host_Scope(){
+		profile.switch_to(outer);
+	}
+};
+
+#ifdef HOST_PROFILE
+#define HOST_PROFILE_SCOPE(sim, section) Host_Scope host_profile_scope(*(sim)->host_profile, section)
+#else
+#define HOST_PROFILE_SCOPE(sim, section)
+#endif
+
+#endif /*HOST_PROFILE_H_*/
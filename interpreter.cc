@@ -0,0 +1,200 @@
+#include "interpreter.h"
+
+Interpreter::Interpreter(sim_ooo *sim){
+	this->sim = sim;
+	instr_memory = sim->instr_memory;
+	instr_memory_size = sim->instr_memory_size;
+	instr_base_address = sim->instr_base_address;
+	linked = false;
+
+	//block leaders: the first instruction, branch targets, the instructions following a branch,
+	//and EOP with the instruction following it (so that EOP is a block of its own)
+	vector<bool> leader(instr_memory_size + 1, false);
+	leader[0] = true;
+	leader[instr_memory_size] = true;
+	for (unsigned i=0; i<instr_memory_size; i++){
+		const instruction_t &instr = instr_memory[i];
+		if (instr.flags & INSTR_BRANCH){
+			leader[i+1] = true;
+			unsigned target = (instr.target - instr_base_address) / 4;
+			if (instr.target >= instr_base_address && target < instr_memory_size) leader[target] = true;
+		}
+		if (instr.opcode == EOP){
+			leader[i] = true;
+			leader[i+1] = true;
+		}
+	}
+
+	entry.assign(instr_memory_size, 0);
+	for (unsigned first=0; first<instr_memory_size; ){
+		unsigned end = first + 1;
+		while (!leader[end]) end++;
+		for (unsigned i=first; i<end; i++){
+			const instruction_t &instr = instr_memory[i];
+			reg_file_element_t *regs = (instr.flags & INSTR_FP) ? sim->fp_reg_file : sim->int_reg_file;
+			micro_op_t op;
+			op.handler = NULL;
+			op.dest = NULL;
+			op.src1 = NULL;
+			op.src2 = NULL;
+			op.immediate = instr.immediate;
+			op.pc = instr_base_address + 4*i;
+			op.length = end - i;
+			op.kind = instr.opcode;
+			switch(instr.opcode){
+				case LW:
+				case LWS:
+					op.dest = &regs[instr.dest].val;
+					op.src1 = &sim->int_reg_file[instr.src1].val;
+					break;
+				case SW:
+				case SWS:
+					op.src1 = &regs[instr.src1].val;
+					op.src2 = &sim->int_reg_file[instr.src2].val;
+					break;
+				case JUMP:
+				case EOP:
+					break;
+				case BEQZ:
+				case BNEZ:
+				case BLTZ:
+				case BGTZ:
+				case BLEZ:
+				case BGEZ:
+					op.src1 = &sim->int_reg_file[instr.src1].val;
+					break;
+				case ADDI:
+				case SUBI:
+					op.dest = &sim->int_reg_file[instr.dest].val;
+					op.src1 = &sim->int_reg_file[instr.src1].val;
+					break;
+				default:
+					op.dest = &regs[instr.dest].val;
+					op.src1 = &regs[instr.src1].val;
+					op.src2 = &regs[instr.src2].val;
+					break;
+			}
+			entry[i] = code.size();
+			code.push_back(op);
+		}
+		const instruction_t &last = instr_memory[end-1];
+		if (!(last.flags & INSTR_BRANCH) && last.opcode != EOP){
+			micro_op_t exit;
+			exit.handler = NULL;
+			exit.dest = exit.src1 = exit.src2 = NULL;
+			exit.immediate = 0;
+			exit.pc = instr_base_address + 4*end;
+			exit.length = 0;
+			exit.kind = OP_EXIT;
+			code.push_back(exit);
+		}
+		first = end;
+	}
+}
+
+unsigned long long Interpreter::run(unsigned long long instructions){
+	//handler of each micro-op kind, in opcode_t order
+	static const void *handlers[NUM_OPCODES + 1] = {
+		&&op_lw, &&op_sw, &&op_add, &&op_addi, &&op_sub, &&op_subi, &&op_xor, &&op_and,
+		&&op_mult, &&op_div, &&op_beqz, &&op_bnez, &&op_bltz, &&op_bgtz, &&op_blez, &&op_bgez,
+		&&op_jump, &&done, &&op_lw, &&op_sw, &&op_adds, &&op_subs, &&op_mults, &&op_divs,
+		&&op_exit};
+	if (!linked){
+		for (unsigned i=0; i<code.size(); i++) code[i].handler = handlers[code[i].kind];
+		linked = true;
+	}
+
+	Data_Memory &memory = sim->data_memory;
+	unsigned memory_size = sim->data_memory_size;
+	unsigned long long executed = 0;
+	unsigned pc = sim->PC;
+	const micro_op_t *op;
+	unsigned address;
+
+#define NEXT goto *(++op)->handler
+
+next_block:
+	if (pc < instr_base_address || (pc - instr_base_address) / 4 >= instr_memory_size) goto done;
+	op = &code[entry[(pc - instr_base_address) / 4]];
+	if (op->kind == EOP || op->length > instructions - executed) goto done;
+	executed += op->length;
+	goto *op->handler;
+
+	//out-of-range loads read UNDEFINED and out-of-range stores are dropped, as in fast_forward
+op_lw:
+	address = *op->src1 + op->immediate;
+	*op->dest = (memory_size >= 4 && address <= memory_size - 4) ? memory.load_word(address) : UNDEFINED;
+	NEXT;
+op_sw:
+	address = *op->src2 + op->immediate;
+	if (memory_size >= 4 && address <= memory_size - 4) memory.store_word(address, *op->src1);
+	NEXT;
+op_add:
+	*op->dest = alu(ADD, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_addi:
+	*op->dest = alu(ADDI, *op->src1, op->immediate, UNDEFINED, op->pc);
+	NEXT;
+op_sub:
+	*op->dest = alu(SUB, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_subi:
+	*op->dest = alu(SUBI, *op->src1, op->immediate, UNDEFINED, op->pc);
+	NEXT;
+op_xor:
+	*op->dest = alu(XOR, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_and:
+	*op->dest = alu(AND, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_mult:
+	*op->dest = alu(MULT, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_div:
+	*op->dest = alu(DIV, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_adds:
+	*op->dest = alu(ADDS, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_subs:
+	*op->dest = alu(SUBS, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_mults:
+	*op->dest = alu(MULTS, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+op_divs:
+	*op->dest = alu(DIVS, *op->src1, *op->src2, UNDEFINED, op->pc);
+	NEXT;
+
+	//the branches end their block
+op_beqz:
+	pc = alu(BEQZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_bnez:
+	pc = alu(BNEZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_bltz:
+	pc = alu(BLTZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_bgtz:
+	pc = alu(BGTZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_blez:
+	pc = alu(BLEZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_bgez:
+	pc = alu(BGEZ, *op->src1, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_jump:
+	pc = alu(JUMP, UNDEFINED, UNDEFINED, op->immediate, op->pc);
+	goto next_block;
+op_exit:
+	pc = op->pc;
+	goto next_block;
+
+#undef NEXT
+
+done:
+	sim->PC = pc;
+	return executed;
+}
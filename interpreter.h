@@ -0,0 +1,55 @@
+#ifndef INTERPRETER_H_
+#define INTERPRETER_H_
+
+#include "sim_ooo.h"
+#include <vector>
+
+using namespace std;
+
+/* Functional interpreter.
+   Executes the program loaded in a simulator on the simulator's own registers and data memory,
+   so that a run can switch between the interpreter and the pipeline at any point where the
+   pipeline is empty (see sim_ooo::fast_forward and sim_ooo::drain).
+
+   The program is predecoded once into basic blocks (split at the branches, at their targets and
+   around EOP). Every instruction becomes a micro-op holding the address of its handler and
+   pointers to its registers, and each block not ending with a branch gets an exit micro-op
+   that falls through to the next block. The handlers jump straight to the handler of the
+   following micro-op (threaded code, with the computed goto of GCC and Clang), and the
+   instruction budget is checked only at block entries: a block is entered only if it fits in
+   the budget, so a run stops at the start of the first block that does not. */
+
+//kind of the micro-op ending a block that falls through to the next one
+#define OP_EXIT NUM_OPCODES
+
+//predecoded instruction
+typedef struct{
+	const void *handler;  // address of the handler (set when the code is linked, see run)
+	unsigned *dest;       // destination register: value field in the simulator register file
+	unsigned *src1;       // first source register (for stores, the register written to memory)
+	unsigned *src2;       // second source register (for stores, the base address register)
+	unsigned immediate;
+	unsigned pc;          // PC of the instruction; for block exits, PC of the next block
+	unsigned length;      // instructions from this one to the end of its block
+	unsigned kind;        // opcode_t, or OP_EXIT
+} micro_op_t;
+
+class Interpreter{
+public:
+	sim_ooo *sim;
+	const instruction_t *instr_memory;  //program predecoded
+	unsigned instr_memory_size;
+	unsigned instr_base_address;
+	vector<micro_op_t> code;            //micro-ops, block after block
+	vector<unsigned> entry;             //position in code of each instruction
+	bool linked;                        //the handlers of the micro-ops are set
+
+	//predecodes the program loaded in the simulator
+	Interpreter(sim_ooo *sim);
+
+	//executes whole blocks from the PC of the simulator while they fit in "instructions", then
+	//returns the number of instructions executed (it stops before EOP and at invalid PCs)
+	unsigned long long run(unsigned long long instructions);
+};
+
+#endif /*INTERPRETER_H_*/
@@ -0,0 +1,44 @@
+#include "pipeview.h"
+#include <stdlib.h>
+#include <iostream>
+
+Pipeview_Writer::Pipeview_Writer(const char *filename){
+	file = fopen(filename, "w");
+	if (file == NULL){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	buffer = new char[PIPEVIEW_BUFFER_SIZE];
+	setvbuf(file, buffer, _IOFBF, PIPEVIEW_BUFFER_SIZE);
+	sequence = 0;
+}
+
+Pipeview_Writer::~Pipeview_Writer(){
+	fclose(file);
+	delete [] buffer;
+}
+
+//tick of a clock cycle (0 if the stage was not reached)
+static inline unsigned long long tick(unsigned long long cycle){
+	return (cycle == UNDEFINED_CYCLE) ? 0 : (cycle + 1) * PIPEVIEW_TICKS_PER_CYCLE;
+}
+
+void Pipeview_Writer::append(const instr_window_entry_t &entry, const instruction_t *instr){
+	unordered_map<unsigned, string>::iterator text = listing.find(entry.pc);
+	if (text == listing.end()) text = listing.insert(make_pair(entry.pc, (instr != NULL) ? disassemble(*instr) : string("?"))).first;
+	unsigned long long front_end = tick(entry.issue);
+	unsigned long long retire = tick(entry.commit);
+	unsigned long long store = (instr != NULL && (instr->flags & INSTR_STORE)) ? retire : 0;
+	sequence++;
+	fprintf(file, "O3PipeView:fetch:%llu:0x%08x:0:%llu:%s\n", front_end, entry.pc, sequence, text->second.c_str());
+	fprintf(file, "O3PipeView:decode:%llu\n", front_end);
+	fprintf(file, "O3PipeView:rename:%llu\n", front_end);
+	fprintf(file, "O3PipeView:dispatch:%llu\n", front_end);
+	fprintf(file, "O3PipeView:issue:%llu\n", tick(entry.exe));
+	fprintf(file, "O3PipeView:complete:%llu\n", tick(entry.wr));
+	fprintf(file, "O3PipeView:retire:%llu:store:%llu\n", retire, store);
+}
+
+void Pipeview_Writer::flush(){
+	fflush(file);
+}
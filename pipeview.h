@@ -0,0 +1,49 @@
+#ifndef PIPEVIEW_H_
+#define PIPEVIEW_H_
+
+#include "sim_ooo.h"
+#include <stdio.h>
+#include <unordered_map>
+
+using namespace std;
+
+/* Pipeline viewer trace.
+   A simulator with a pipeline trace (see sim_ooo::set_pipeview_file) writes every instruction
+   it logs, committed or squashed, to a text file in the gem5 O3PipeView format, which both the
+   Konata pipeline viewer and gem5's util/o3-pipeview.py read. An instruction is written as soon
+   as it leaves the pipeline, through a large stdio buffer, so a multi-million-cycle run holds
+   nothing in memory but the buffer and the text of each static instruction.
+
+   The simulator has a single in-order front-end stage, so its issue cycle is reported as the
+   fetch, decode, rename and dispatch ticks; "issue" is the start of execution, "complete" the
+   write result and "retire" the commit (for stores, the start of the commit, also reported as
+   the store tick). Cycle c is tick (c+1)*PIPEVIEW_TICKS_PER_CYCLE, as tick 0 marks a stage the
+   instruction did not reach: a squashed instruction retires at tick 0. */
+
+//ticks per clock cycle (the default clock period of gem5, in ps)
+#define PIPEVIEW_TICKS_PER_CYCLE 1000
+
+//size of the output buffer of a pipeline trace
+#define PIPEVIEW_BUFFER_SIZE (1 << 20)
+
+class Pipeview_Writer{
+public:
+	FILE *file;
+	char *buffer;
+	unsigned long long sequence;               //instructions written
+	unordered_map<unsigned, string> listing;  //assembly text of the instructions written, by PC
+
+	//creates the trace file
+	Pipeview_Writer(const char *filename);
+
+	//writes what is left in the buffer and closes the file
+	~Pipeview_Writer();
+
+	//writes an instruction that left the pipeline (instr is NULL if the PC is outside instruction memory)
+	void append(const instr_window_entry_t &entry, const instruction_t *instr);
+
+	//writes the buffer to the file
+	void flush();
+};
+
+#endif /*PIPEVIEW_H_*/
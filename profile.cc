@@ -0,0 +1,94 @@
+#include "profile.h"
+#include <iomanip>
+
+void Instruction_Profile::record(unsigned index, const instr_window_entry_t &entry){
+	if (index >= entries.size()){
+		instr_profile_t blank;
+		memset(&blank, 0, sizeof blank);
+		entries.resize(index + 1, blank);
+	}
+	instr_profile_t &profile = entries[index];
+	//a squashed instruction never committed
+	if (entry.commit == UNDEFINED_CYCLE){
+		profile.squashes++;
+		return;
+	}
+	profile.commits++;
+	unsigned long long stages[NUM_INTERVALS + 1] = {entry.issue, entry.exe, entry.wr, entry.commit};
+	for (unsigned s=0; s<NUM_INTERVALS; s++){
+		if (stages[s] == UNDEFINED_CYCLE || stages[s+1] == UNDEFINED_CYCLE) continue;
+		unsigned long long cycles = stages[s+1] - stages[s];
+		latency_stat_t &latency = profile.latency[s];
+		latency.count++;
+		latency.total += cycles;
+		if (cycles > latency.max) latency.max = cycles;
+	}
+}
+
+void Instruction_Profile::clear(){
+	entries.clear();
+}
+
+//width of the counter columns of the listing
+#define PROFILE_COUNTERS_WIDTH 74
+
+//prints the counters of an instruction (blank if it never left the pipeline)
+static void print_counters(ostream &out, const instr_profile_t *profile, unsigned long long cycles, unsigned long long total){
+	if (profile == NULL || profile->commits + profile->squashes == 0){
+		out << setw(PROFILE_COUNTERS_WIDTH) << "";
+		return;
+	}
+	out << setw(6) << setprecision(1) << (total ? 100.0 * cycles / total : 0) << "%" << setw(12) << profile->commits << setw(10) << profile->squashes;
+	for (unsigned s=0; s<NUM_INTERVALS; s++){
+		const latency_stat_t &latency = profile->latency[s];
+		if (latency.count == 0) out << setw(15) << "";
+		else out << setw(8) << setprecision(2) << (double)latency.total / latency.count << setw(7) << latency.max;
+	}
+}
+
+void Instruction_Profile::print(ostream &out, const program_image_t *image, const instruction_t *instr_memory, unsigned instr_memory_size, unsigned base_address){
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+
+	//the shares are of the cycles from issue to commit
+	vector<unsigned long long> cycles(instr_memory_size, 0);
+	unsigned long long total = 0;
+	for (unsigned i=0; i<instr_memory_size && i<entries.size(); i++){
+		for (unsigned s=0; s<NUM_INTERVALS; s++) cycles[i] += entries[i].latency[s].total;
+		total += cycles[i];
+	}
+
+	out << "PROFILE" << endl;
+	out << setfill(' ') << right << fixed << setw(7) << "share" << setw(12) << "commits" << setw(10) << "squashes"
+	    << setw(8) << "i>e avg" << setw(7) << "max" << setw(8) << "e>w avg" << setw(7) << "max" << setw(8) << "w>c avg" << setw(7) << "max"
+	    << "  " << left << setw(12) << "pc" << "source" << right << endl;
+
+	//the program source, when the instructions were parsed from it
+	bool listing = (image != NULL && !image->source.empty() && instr_memory == &image->instructions[0]);
+	if (listing){
+		vector<unsigned> instr_of_line(image->source.size(), UNDEFINED);
+		for (unsigned i=0; i<instr_memory_size && i<image->source_line.size(); i++){
+			if (image->source_line[i] != UNDEFINED) instr_of_line[image->source_line[i]] = i;
+		}
+		for (unsigned l=0; l<image->source.size(); l++){
+			string text = image->source[l];
+			if (!text.empty() && text[text.size() - 1] == '\r') text.erase(text.size() - 1);
+			unsigned i = instr_of_line[l];
+			if (i == UNDEFINED){
+				out << setw(PROFILE_COUNTERS_WIDTH) << "" << "  " << setw(12) << "" << text << endl;
+				continue;
+			}
+			print_counters(out, (i < entries.size()) ? &entries[i] : NULL, cycles[i], total);
+			out << "  0x" << hex << setfill('0') << setw(8) << base_address + 4*i << dec << setfill(' ') << "  " << text << endl;
+		}
+	} else {
+		for (unsigned i=0; i<instr_memory_size; i++){
+			if (instr_memory[i].opcode == EOP) break;
+			print_counters(out, (i < entries.size()) ? &entries[i] : NULL, cycles[i], total);
+			out << "  0x" << hex << setfill('0') << setw(8) << base_address + 4*i << dec << setfill(' ') << "  " << disassemble(instr_memory[i]) << endl;
+		}
+	}
+	out << endl;
+	out.flags(flags);
+	out.precision(precision);
+}
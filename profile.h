@@ -0,0 +1,55 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include "sim_ooo.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/* Per-instruction profile.
+   A simulator with a profile (see sim_ooo::enable_profile) aggregates every instruction it logs,
+   committed or squashed, into the counters of its static instruction as it leaves the pipeline:
+   the number of commits and squashes, and the count, total and maximum of the clock cycles each
+   committed instance spent from issue to execute, from execute to write result and from write
+   result to commit (for stores, to the start of the commit). The profile takes one entry per
+   instruction of the program, however long the run, so it works where the full log cannot be
+   kept.
+
+   The profile is printed as the program source, each instruction annotated with its counters and
+   with its share of the cycles all the committed instructions spent between issue and commit
+   (see sim_ooo::print_profile). */
+
+//intervals between the stages of an instruction
+typedef enum {ISSUE_TO_EXE, EXE_TO_WR, WR_TO_COMMIT, NUM_INTERVALS} interval_t;
+
+//clock cycles an instruction spent in an interval
+typedef struct{
+	unsigned long long count;   //instances measured
+	unsigned long long total;   //sum of their clock cycles
+	unsigned long long max;     //longest of them
+} latency_stat_t;
+
+//counters of a static instruction
+typedef struct{
+	unsigned long long commits;
+	unsigned long long squashes;
+	latency_stat_t latency[NUM_INTERVALS];
+} instr_profile_t;
+
+class Instruction_Profile{
+public:
+	vector<instr_profile_t> entries;   //by instruction index in instruction memory
+
+	//adds an instruction that left the pipeline, at index "index" in instruction memory
+	void record(unsigned index, const instr_window_entry_t &entry);
+
+	//empties the profile
+	void clear();
+
+	//prints the annotated listing of a program: its source lines if known, the disassembly of
+	//its instructions otherwise
+	void print(ostream &out, const program_image_t *image, const instruction_t *instr_memory, unsigned instr_memory_size, unsigned base_address);
+};
+
+#endif /*PROFILE_H_*/
@@ -1,4 +1,11 @@
 #include "sim_ooo.h"
+#include "functional.h"
+#include "commit_log.h"
+#include "pipeview.h"
+#include "interpreter.h"
+#include "checkpoint.h"
+#include "profile.h"
+#include "host_profile.h"
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
@@ -6,6 +13,16 @@
 #include <string>
 #include <iomanip>
 #include <map>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
 using namespace std;
@@ -15,22 +32,16 @@ static const char *stage_names[NUM_STAGES] = {"ISSUE", "EXE", "WR", "COMMIT"};
 static const char *instr_names[NUM_OPCODES] = {"LW", "SW", "ADD", "ADDI", "SUB", "SUBI", "XOR", "AND", "MULT", "DIV", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS"};
 static const char *res_station_names[5]={"Int", "Add", "Mult", "Load"};
 
-unsigned mBaseAddr;
-unsigned mDataMemSize;
-unsigned mROBTotalEntries;
-bool isBranchMispredicted = false;
-unsigned currClkCycle;
-instruction_t *mInstrMemPtr;
-sim_ooo * currSim;
-unit_t mDummyExeUnit[MAX_UNITS];
-unsigned mNumDummyUnits;
-unsigned mCurrDummyUnitIndex = 0;
+const char *cpi_component_names[NUM_CPI_COMPONENTS] = {"base", "rob_full", "rs_full_int", "rs_full_add", "rs_full_mult", "rs_full_load",
+	"fu_busy_integer", "fu_busy_adder", "fu_busy_multiplier", "fu_busy_divider", "fu_busy_memory", "memory_order", "branch_flush"};
+const char *stall_event_names[NUM_STALL_EVENTS] = {"rob_full", "rs_full_int", "rs_full_add", "rs_full_mult", "rs_full_load", "operand_wait",
+	"fu_busy_integer", "fu_busy_adder", "fu_busy_multiplier", "fu_busy_divider", "fu_busy_memory", "memory_order", "store_commit", "branch_flush"};
+
 /* =============================================================
 
    HELPER FUNCTIONS (misc)
 
    ============================================================= */
-inline bool isValidPC(unsigned mPC);
 inline bool isLoadInstr(opcode_t mOpCode);
 inline bool isStoreInstr(opcode_t mOpCode);
 bool isOpcodeFpType(opcode_t mOpCode);
@@ -38,36 +49,92 @@ void sim_Commit_Handler(sim_ooo * mSim);
 void sim_WB_Handler(sim_ooo * mSim);
 void sim_Exe_Handler(sim_ooo * mSim);
 void sim_Issue_Handler(sim_ooo * mSim);
-unsigned search_exe_unit(unsigned mPC);
-void update_instr_window(unsigned mPC, stage_t mStage);
-void store_bypassing_wb_handler(unsigned mPC);
-unsigned search_prev_load_store(res_station_entry_t * mStation);
-
-/* convert a float into an unsigned */
-inline unsigned float2unsigned(float value){
-	unsigned result;
-	memcpy(&result, &value, sizeof value);
-	return result;
+unsigned search_exe_unit(sim_ooo * mSim, unsigned mPC);
+void update_instr_window(sim_ooo * mSim, unsigned mPC, stage_t mStage);
+void store_bypassing_wb_handler(sim_ooo * mSim, unsigned mROBIndex);
+void blame_stall(sim_ooo * mSim, unsigned mComponent, unsigned mROBIndex);
+
+/* tag comparison kernels of the reservation stations: each call checks a block of 64
+   stations and returns one bit per station. AVX2 compares 8 stations per instruction,
+   SSE2 (always available on x86-64) 4, the scalar version is used on other targets.
+   The CDB write cycles are 64-bit: as they lie in [-1, now], cycles[i] < now is the sign
+   of cycles[i] - now, which needs no 64-bit comparison instruction */
+#if defined(__AVX2__)
+inline unsigned long long match_tag(const unsigned *tags, unsigned key){
+        unsigned long long mask = 0;
+        __m256i k = _mm256_set1_epi32(key);
+        for(unsigned i=0; i<64; i+=8){
+                __m256i t = _mm256_loadu_si256((const __m256i *)(tags + i));
+                unsigned m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(t, k)));
+                mask |= (unsigned long long)m << i;
+        }
+        return mask;
+}
+
+inline unsigned long long match_ready(const unsigned *tags1, const unsigned *tags2, const long long *cycles, long long now){
+        unsigned long long mask = 0;
+        __m256i undef = _mm256_set1_epi32(UNDEFINED);
+        __m256i n = _mm256_set1_epi64x(now);
+        for(unsigned i=0; i<64; i+=8){
+                __m256i t1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(tags1 + i)), undef);
+                __m256i t2 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(tags2 + i)), undef);
+                __m256i c0 = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(cycles + i)), n);
+                __m256i c1 = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(cycles + i + 4)), n);
+                unsigned c = _mm256_movemask_pd(_mm256_castsi256_pd(c0)) | (_mm256_movemask_pd(_mm256_castsi256_pd(c1)) << 4);
+                unsigned m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(t1, t2))) & c;
+                mask |= (unsigned long long)m << i;
+        }
+        return mask;
+}
+#elif defined(__SSE2__)
+inline unsigned long long match_tag(const unsigned *tags, unsigned key){
+        unsigned long long mask = 0;
+        __m128i k = _mm_set1_epi32(key);
+        for(unsigned i=0; i<64; i+=4){
+                __m128i t = _mm_loadu_si128((const __m128i *)(tags + i));
+                unsigned m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(t, k)));
+                mask |= (unsigned long long)m << i;
+        }
+        return mask;
+}
+
+inline unsigned long long match_ready(const unsigned *tags1, const unsigned *tags2, const long long *cycles, long long now){
+        unsigned long long mask = 0;
+        __m128i undef = _mm_set1_epi32(UNDEFINED);
+        __m128i n = _mm_set1_epi64x(now);
+        for(unsigned i=0; i<64; i+=4){
+                __m128i t1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(tags1 + i)), undef);
+                __m128i t2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(tags2 + i)), undef);
+                __m128i c0 = _mm_sub_epi64(_mm_loadu_si128((const __m128i *)(cycles + i)), n);
+                __m128i c1 = _mm_sub_epi64(_mm_loadu_si128((const __m128i *)(cycles + i + 2)), n);
+                unsigned c = _mm_movemask_pd(_mm_castsi128_pd(c0)) | (_mm_movemask_pd(_mm_castsi128_pd(c1)) << 2);
+                unsigned m = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(t1, t2))) & c;
+                mask |= (unsigned long long)m << i;
+        }
+        return mask;
 }
-
-/* convert an unsigned into a float */
-inline float unsigned2float(unsigned value){
-	float result;
-	memcpy(&result, &value, sizeof value);
-	return result;
+#else
+inline unsigned long long match_tag(const unsigned *tags, unsigned key){
+        unsigned long long mask = 0;
+        for(unsigned i=0; i<64; i++)
+                mask |= (unsigned long long)(tags[i] == key) << i;
+        return mask;
 }
 
-/* convert integer into array of unsigned char - little indian */
-inline void unsigned2char(unsigned value, unsigned char *buffer){
-        buffer[0] = value & 0xFF;
-        buffer[1] = (value >> 8) & 0xFF;
-        buffer[2] = (value >> 16) & 0xFF;
-        buffer[3] = (value >> 24) & 0xFF;
+inline unsigned long long match_ready(const unsigned *tags1, const unsigned *tags2, const long long *cycles, long long now){
+        unsigned long long mask = 0;
+        for(unsigned i=0; i<64; i++)
+                mask |= (unsigned long long)((tags1[i] == UNDEFINED) && (tags2[i] == UNDEFINED) && (cycles[i] < now)) << i;
+        return mask;
 }
+#endif
 
-/* convert array of char into integer - little indian */
-inline unsigned char2unsigned(unsigned char *buffer){
-       return buffer[0] + (buffer[1] << 8) + (buffer[2] << 16) + (buffer[3] << 24);
+//returns a new copy of an array (NULL if the array is NULL)
+template <typename T> T *copy_array(const T *src, unsigned n){
+	if (src == NULL) return NULL;
+	T *dst = new T[n];
+	memcpy(dst, src, n*sizeof(T));
+	return dst;
 }
 
 /* the following six functions return the kind of the considered opcdoe */
@@ -105,89 +172,76 @@ void clean_rob(rob_entry_t *entry){
         entry->value=UNDEFINED;
 }
 
-/* clears a reservation station */
-void clean_res_station(res_station_entry_t *entry){
-        entry->pc=UNDEFINED;
-        entry->value1=UNDEFINED;
-        entry->value2=UNDEFINED;
-        entry->tag1=UNDEFINED;
-        entry->tag2=UNDEFINED;
-        entry->destination=UNDEFINED;
-        entry->address=UNDEFINED;
-        entry->CDBWriteDataAvailClkCycle= -1;
-        entry->CDBWriteDataAvailClkCyclevalue2 = -1;
+/* the following functions write or read an instruction or an entry of the pipeline structures to
+   or from a checkpoint, field by field (so that no struct padding reaches the file) */
+void checkpoint_instruction(Checkpoint_Stream &stream, instruction_t &instr){
+        stream.io(instr.opcode);
+        stream.io(instr.src1);
+        stream.io(instr.src2);
+        stream.io(instr.dest);
+        stream.io(instr.immediate);
+        stream.io(instr.target);
+        stream.io(instr.flags);
+        stream.io(instr.unit);
+        stream.io(instr.station);
+}
+
+void checkpoint_window_entry(Checkpoint_Stream &stream, instr_window_entry_t &entry){
+        stream.io(entry.pc);
+        stream.io(entry.issue);
+        stream.io(entry.exe);
+        stream.io(entry.wr);
+        stream.io(entry.commit);
+}
+
+void checkpoint_unit(Checkpoint_Stream &stream, unit_t &unit){
+        stream.io(unit.type);
+        stream.io(unit.latency);
+        stream.io(unit.completion);
+        stream.io(unit.pc);
+        stream.io_instr(unit.unit_instr);
+        stream.io(unit.output);
+        stream.io(unit.reservationStationIndex);
+        stream.io(unit.rob_index);
+        stream.io(unit.isAvailable);
+}
+
+void checkpoint_rob_entry(Checkpoint_Stream &stream, rob_entry_t &entry){
+        stream.io(entry.ready);
+        stream.io(entry.pc);
+        stream.io_instr(entry.entry_instr);
+        stream.io(entry.state);
+        stream.io(entry.destination);
+        stream.io(entry.value);
+        stream.io(entry.isAvailable);
+        stream.io(entry.isAddressComputed);
+        stream.io(entry.station);
+        stream.io(entry.exe_unit);
+}
+
+void checkpoint_station(Checkpoint_Stream &stream, res_station_entry_t &entry){
+        stream.io(entry.name);
+        stream.io(entry.pc);
+        stream.io_instr(entry.entry_instr);
+        stream.io(entry.destination);
+        stream.io(entry.address);
+        stream.io(entry.isAvailable);
+        stream.io(entry.CDBWriteDataAvailClkCyclevalue2);
 }
 
 /* clears an entry if the instruction window */
 void clean_instr_window(instr_window_entry_t *entry){
         entry->pc=UNDEFINED;
-        entry->issue=UNDEFINED;
-        entry->exe=UNDEFINED;
-        entry->wr=UNDEFINED;
-        entry->commit=UNDEFINED;
-}
-
-/* implements the ALU operation 
-   NOTE: this function does not cover LOADS and STORES!
-*/
-unsigned alu(opcode_t opcode, unsigned value1, unsigned value2, unsigned immediate, unsigned pc){
-	unsigned result;
-	switch(opcode){
-			case ADD:
-			case ADDI:
-				result = value1+value2;
-				break;
-			case SUB:
-			case SUBI:
-				result = value1-value2;
-				break;
-			case XOR:
-				result = value1 ^ value2;
-				break;
-			case AND:
-				result = value1 & value2;
-				break;
-			case MULT:
-				result = value1 * value2;
-				break;
-			case DIV:
-				result = value1 / value2;
-				break;
-			case ADDS:
-				result = float2unsigned(unsigned2float(value1) + unsigned2float(value2));
-				break;
-			case SUBS:
-				result = float2unsigned(unsigned2float(value1) - unsigned2float(value2));
-				break;
-			case MULTS:
-				result = float2unsigned(unsigned2float(value1) * unsigned2float(value2));
-				break;
-			case DIVS:
-				result = float2unsigned(unsigned2float(value1) / unsigned2float(value2));
-				break;
-			case JUMP:
-				result = pc + 4 + immediate;
-				break;
-			default: //branches
-				int reg = (int) value1;
-				bool condition = ((opcode == BEQZ && reg==0) ||
-				(opcode == BNEZ && reg!=0) ||
-  				(opcode == BGEZ && reg>=0) ||
-  				(opcode == BLEZ && reg<=0) ||      
-  				(opcode == BGTZ && reg>0) ||       
-  				(opcode == BLTZ && reg<0));
-				if (condition)
-	 				result = pc+4+immediate;
-				else 
-					result = pc+4;
-				break;
-	}
-	return 	result;
+        entry->issue=UNDEFINED_CYCLE;
+        entry->exe=UNDEFINED_CYCLE;
+        entry->wr=UNDEFINED_CYCLE;
+        entry->commit=UNDEFINED_CYCLE;
 }
 
+
 /* writes the data memory at the specified address */
 void sim_ooo::write_memory(unsigned address, unsigned value){
-	unsigned2char(value,data_memory+address);
+	data_memory.store_word(address, value);
 }
 
 /* =============================================================
@@ -205,73 +259,395 @@ void sim_ooo::init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned in
                 {
                     //exec_units[num_units].latency--;
                 }
-                exec_units[num_units].busy = 0;
+                exec_units[num_units].completion = 0;
                 exec_units[num_units].pc = UNDEFINED;
+                exec_units[num_units].unit_instr = NULL;
                 exec_units[num_units].isAvailable = true;
-
-                mDummyExeUnit[num_units].pc = UNDEFINED;
-                mDummyExeUnit[num_units].isAvailable = true;
-                mDummyExeUnit[num_units].latency = 1;
-                mDummyExeUnit[num_units].busy = 0;
-                mDummyExeUnit[num_units].reservationStationIndex = UNDEFINED;
+                free_units[exec_unit] |= (1u << num_units);
+
+                dummy_units[num_units].pc = UNDEFINED;
+                dummy_units[num_units].unit_instr = NULL;
+                dummy_units[num_units].isAvailable = true;
+                dummy_units[num_units].latency = 1;
+                dummy_units[num_units].completion = 0;
+                dummy_units[num_units].reservationStationIndex = UNDEFINED;
                 num_units++;
-                mNumDummyUnits++;
+                num_dummy_units++;
         }
+        wheel.resize(latency);
 
 }
 
 /* returns a free unit for that particular operation or UNDEFINED if no unit is currently available */
-unsigned sim_ooo::get_free_unit(opcode_t opcode){
+unsigned sim_ooo::get_free_unit(const instruction_t *instr){
 	if (num_units == 0){
 		cout << "ERROR:: simulator does not have any execution units!\n";
 		exit(-1);
 	}
-	for (unsigned u=0; u<num_units; u++){
-		switch(opcode){
-			//Integer unit
-			case ADD:
-			case ADDI:
-			case SUB:
-			case SUBI:
-			case XOR:
-			case AND:
-			case BEQZ:
-			case BNEZ:
-			case BLTZ:
-			case BGTZ:
-			case BLEZ:
-			case BGEZ:
-			case JUMP:
-				if (exec_units[u].isAvailable==true && exec_units[u].type==INTEGER && exec_units[u].busy==0 && exec_units[u].pc==UNDEFINED) return u;
-				break;
-			//memory unit
-			case LW:
-			case SW:
-			case LWS: 
-			case SWS:
-				if (exec_units[u].isAvailable==true && exec_units[u].type==MEMORY && exec_units[u].busy==0 && exec_units[u].pc==UNDEFINED) return u;
-				break;
-			// FP adder
-			case ADDS:
-			case SUBS:
-				if (exec_units[u].isAvailable==true && exec_units[u].type==ADDER && exec_units[u].busy==0 && exec_units[u].pc==UNDEFINED) return u;
-				break;
-			// Multiplier
-			case MULT:
-			case MULTS:
-				if (exec_units[u].isAvailable==true && exec_units[u].type==MULTIPLIER && exec_units[u].busy==0 && exec_units[u].pc==UNDEFINED) return u;
-				break;
-			// Divider
-			case DIV:
-			case DIVS:
-				if (exec_units[u].isAvailable==true && exec_units[u].type==DIVIDER && exec_units[u].busy==0 && exec_units[u].pc==UNDEFINED) return u;
-				break;
-			default:
-				cout << "ERROR:: operations not requiring exec unit!\n";
-				exit(-1);
-		}
+	if (instr->unit == UNDEFINED_UNIT){
+		cout << "ERROR:: operations not requiring exec unit!\n";
+		exit(-1);
+	}
+	//lowest-numbered free unit of the required type
+	if (free_units[instr->unit] == 0) return UNDEFINED;
+	return __builtin_ctz(free_units[instr->unit]);
+}
+
+/* predecodes an instruction: class bits, execution unit and reservation station types */
+void predecode(instruction_t *instr, unsigned pc){
+	instr->flags = 0;
+	if (is_branch(instr->opcode)) instr->flags |= INSTR_BRANCH;
+	if (is_memory(instr->opcode)) instr->flags |= INSTR_MEMORY;
+	if (instr->opcode == LW || instr->opcode == LWS) instr->flags |= INSTR_LOAD;
+	if (instr->opcode == SW || instr->opcode == SWS) instr->flags |= INSTR_STORE;
+	if (isOpcodeFpType(instr->opcode)) instr->flags |= INSTR_FP;
+	instr->target = is_branch(instr->opcode) ? pc + 4 + instr->immediate : UNDEFINED;
+	switch(instr->opcode){
+		//Integer unit
+		case ADD:
+		case ADDI:
+		case SUB:
+		case SUBI:
+		case XOR:
+		case AND:
+		case BEQZ:
+		case BNEZ:
+		case BLTZ:
+		case BGTZ:
+		case BLEZ:
+		case BGEZ:
+		case JUMP:
+			instr->unit = INTEGER;
+			instr->station = INTEGER_RS;
+			break;
+		//memory unit
+		case LW:
+		case SW:
+		case LWS: 
+		case SWS:
+			instr->unit = MEMORY;
+			instr->station = LOAD_B;
+			break;
+		// FP adder
+		case ADDS:
+		case SUBS:
+			instr->unit = ADDER;
+			instr->station = ADD_RS;
+			break;
+		// Multiplier
+		case MULT:
+		case MULTS:
+			instr->unit = MULTIPLIER;
+			instr->station = MULT_RS;
+			break;
+		// Divider
+		case DIV:
+		case DIVS:
+			instr->unit = DIVIDER;
+			instr->station = MULT_RS;
+			break;
+		default:
+			instr->unit = UNDEFINED_UNIT;
+			instr->station = MAX_RS;
+			break;
+	}
+}
+
+/* marks an execution unit as busy: the unit completes after "latency" clock cycles (at least one) */
+void sim_ooo::start_exec_unit(unsigned unit){
+        unsigned latency = (exec_units[unit].latency > 0) ? exec_units[unit].latency : 1;
+        exec_units[unit].completion = current_cycle + latency - 1;
+        wheel.schedule(unit, exec_units[unit].completion);
+        free_units[exec_units[unit].type] &= ~(1u << unit);
+        if (latency_watch & (1u << exec_units[unit].type)) latency_diverged = true;
+}
+
+/* frees an execution unit: a unit taken from a reservation station becomes available in the next clock cycle */
+void sim_ooo::release_exec_unit(unsigned unit){
+        if (exec_units[unit].pc == UNDEFINED) return;
+        wheel.cancel(unit, exec_units[unit].completion);
+        exec_units[unit].pc = UNDEFINED;
+        if (exec_units[unit].isAvailable) free_units[exec_units[unit].type] |= (1u << unit);
+        else defer_release(RELEASE_UNIT, unit);
+}
+
+/* frees all the execution units immediately */
+void sim_ooo::flush_exec_units(){
+        for (unsigned u = 0; u < NUM_UNIT_TYPES; u++) free_units[u] = 0;
+        for (unsigned u = 0; u < num_units; u++){
+                exec_units[u].pc = UNDEFINED;
+                exec_units[u].isAvailable = true;
+                free_units[exec_units[u].type] |= (1u << u);
+        }
+        wheel.clear();
+}
+
+void sim_ooo::squash(){
+        //the squashed instructions are logged with the stages they reached
+        unsigned n=0;
+        for(unsigned i=rob->get_head_index();n<rob->currLength;i=(i+1)%rob->num_entries,n++)
+        {
+                commit_to_log(pending_instructions.entries[i]);
+        }
+        PC = redirect_pc;
+        redirect_pc = UNDEFINED;
+        //the wrong-path records not issued are dropped from the trace
+        if ((trace != NULL) && (trace_wrong_path > 0)){
+                trace->skip(trace_consumer, trace_wrong_path);
+                trace_wrong_path = 0;
+        }
+        if (!isValidPC(PC)) {
+                //std::cout << "\n//TODO: error handling invalid PC loaded at commit";
+        }
+        //everything released in this cycle is available again together with the squashed resources
+        process_releases();
+        rob->flush();
+        reservation_stations->flush();
+        lsq->flush();
+        flush_exec_units();
+        //address computations in flight are dropped as well
+        for (unsigned u = 0; u < num_dummy_units; u++){
+                if (isValidPC(dummy_units[u].pc)){
+                        curr_dummy_unit--;
+                        dummy_units[u].pc = UNDEFINED;
+                        dummy_units[u].isAvailable = true;
+                }
+        }
+        //the branch was the oldest instruction, so no register is waiting for a result
+        for (int i = 0; i < NUM_GP_REGISTERS; i++){
+                int_reg_file[i].tag = UNDEFINED;
+                fp_reg_file[i].tag = UNDEFINED;
+        }
+        count_stall(STALL_BRANCH_FLUSH);
+        flushing = true;
+        cycle_progress = true;
+}
+void sim_ooo::defer_release(release_t kind, unsigned index){
+        release_queue[release_count].kind = kind;
+        release_queue[release_count].index = index;
+        release_count++;
+}
+
+/* makes the ROB entries, reservation stations and exe units released in the previous cycle available */
+void sim_ooo::process_releases(){
+        if (release_count > 0) cycle_progress = true;
+        for (unsigned i = 0; i < release_count; i++){
+                unsigned index = release_queue[i].index;
+                switch(release_queue[i].kind){
+                        case RELEASE_ROB:
+                                rob->entries[index].isAvailable = true;
+                                break;
+                        case RELEASE_STATION:
+                                reservation_stations->free_station(index);
+                                break;
+                        case RELEASE_UNIT:
+                                exec_units[index].isAvailable = true;
+                                free_units[exec_units[index].type] |= (1u << index);
+                                break;
+                }
+        }
+        release_count = 0;
+}
+
+void sim_ooo::set_event_driven(bool enable){
+        event_driven = enable;
+}
+
+void sim_ooo::attach_trace(Trace_Ring *ring, unsigned consumer){
+	//the wrong path of a taken branch is as long as the instructions that can follow it in the ROB
+	if (rob->num_entries - 1 > ring->window){
+		cout << "ERROR:: the functional trace does not cover the wrong paths of this ROB!\n";
+		exit(-1);
 	}
-	return UNDEFINED;
+	trace = ring;
+	trace_consumer = consumer;
+	delete [] trace_records;
+	trace_records = new trace_record_t[rob->num_entries];
+	trace_wrong_path = 0;
+}
+
+void sim_ooo::read_trace(unsigned pc){
+	trace_record_t *record = &trace_records[rob->get_entry_num(pc)];
+	if (!trace->pop(trace_consumer, record) || (record->pc != pc)){
+		cout << "ERROR:: the instructions issued do not match the functional trace!\n";
+		exit(-1);
+	}
+	if (trace_wrong_path > 0) trace_wrong_path--;
+	else trace_wrong_path = record->wrong_path;
+}
+
+void sim_ooo::set_unit_latency(exe_unit_t exec_unit, unsigned latency){
+        unsigned new_latency = (latency > 0) ? latency : 1;
+        for (unsigned u = 0; u < num_units; u++){
+                if (exec_units[u].type != exec_unit) continue;
+                unsigned old_latency = (exec_units[u].latency > 0) ? exec_units[u].latency : 1;
+                if (exec_units[u].pc != UNDEFINED) exec_units[u].completion = exec_units[u].completion - old_latency + new_latency;
+                exec_units[u].latency = latency;
+        }
+        //the busy units are rescheduled, on a wheel large enough for the new latency
+        wheel.resize(latency);
+        wheel.clear();
+        for (unsigned u = 0; u < num_units; u++){
+                if (exec_units[u].pc != UNDEFINED) wheel.schedule(u, exec_units[u].completion);
+        }
+}
+
+/* =============================================================
+
+   Free lists
+
+   ============================================================= */
+
+Free_List::Free_List() {
+    num_words = 0;
+    words = NULL;
+}
+
+Free_List::~Free_List() {
+    delete [] words;
+}
+
+void Free_List::init(unsigned mSize) {
+    delete [] words;
+    num_words = (mSize + 63)/64;
+    words = new unsigned long long[num_words];
+    for(unsigned i=0; i<num_words; i++)
+    {
+        words[i] = 0;
+    }
+}
+
+void Free_List::copy(const Free_List &other) {
+    delete [] words;
+    num_words = other.num_words;
+    words = new unsigned long long[num_words];
+    memcpy(words, other.words, num_words*sizeof(unsigned long long));
+}
+
+//writes or reads the list to or from a checkpoint (the sizes must match)
+void Free_List::checkpoint(Checkpoint_Stream &stream) {
+    stream.check(num_words, "free list size");
+    stream.io_array(words, num_words);
+}
+
+void Free_List::set(unsigned i) {
+    words[i/64] |= (1ull << (i%64));
+}
+
+void Free_List::clear(unsigned i) {
+    words[i/64] &= ~(1ull << (i%64));
+}
+
+bool Free_List::isEmpty() {
+    for(unsigned w=0; w<num_words; w++)
+    {
+        if(words[w] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//lowest available resource, UNDEFINED if none
+unsigned Free_List::first() {
+    for(unsigned w=0; w<num_words; w++)
+    {
+        if(words[w] != 0)
+        {
+            return w*64 + __builtin_ctzll(words[w]);
+        }
+    }
+    return UNDEFINED;
+}
+
+/* =============================================================
+
+   Timing wheel (event-driven core)
+
+   ============================================================= */
+
+Timing_Wheel::Timing_Wheel() {
+    num_slots = 0;
+    slots = NULL;
+    pending = 0;
+    resize(0);
+}
+
+Timing_Wheel::~Timing_Wheel() {
+    delete [] slots;
+}
+
+//grows the wheel so that every completion within "max_latency" cycles maps to a distinct slot;
+//growing it drops every scheduled event, so a caller resizing it mid-run (see set_unit_latency)
+//must reschedule all the pending completions afterwards
+void Timing_Wheel::resize(unsigned max_latency) {
+    unsigned mSlots = 1;
+    while(mSlots <= max_latency)
+    {
+        mSlots <<= 1;
+    }
+    if(mSlots > num_slots)
+    {
+        //the slots of the old wheel are not rehashed: the pending events are lost
+        delete [] slots;
+        num_slots = mSlots;
+        slots = new unsigned[num_slots];
+        clear();
+    }
+}
+
+void Timing_Wheel::copy(const Timing_Wheel &other) {
+    delete [] slots;
+    num_slots = other.num_slots;
+    slots = new unsigned[num_slots];
+    memcpy(slots, other.slots, num_slots*sizeof(unsigned));
+    pending = other.pending;
+}
+
+void Timing_Wheel::checkpoint(Checkpoint_Stream &stream) {
+    stream.check(num_slots, "timing wheel size");
+    stream.io_array(slots, num_slots);
+    stream.io(pending);
+}
+
+void Timing_Wheel::schedule(unsigned unit, unsigned long long cycle) {
+    slots[cycle & (num_slots - 1)] |= (1u << unit);
+    pending++;
+}
+
+void Timing_Wheel::cancel(unsigned unit, unsigned long long cycle) {
+    unsigned *mSlot = &slots[cycle & (num_slots - 1)];
+    if((*mSlot) & (1u << unit))
+    {
+        *mSlot &= ~(1u << unit);
+        pending--;
+    }
+}
+
+void Timing_Wheel::clear() {
+    for(unsigned i=0; i<num_slots; i++)
+    {
+        slots[i] = 0;
+    }
+    pending = 0;
+}
+
+//returns the first clock cycle >= "cycle" in which a unit completes (UNDEFINED_CYCLE if no unit is busy)
+//Note: all the scheduled completions must lie in [cycle, cycle + num_slots)
+unsigned long long Timing_Wheel::next_event(unsigned long long cycle) {
+    if(pending == 0)
+    {
+        return UNDEFINED_CYCLE;
+    }
+    for(unsigned i=0; i<num_slots; i++)
+    {
+        if(slots[(cycle + i) & (num_slots - 1)] != 0)
+        {
+            return cycle + i;
+        }
+    }
+    return UNDEFINED_CYCLE;
 }
 
 
@@ -291,179 +667,226 @@ unsigned sim_ooo::get_free_unit(opcode_t opcode){
 
 /* prints the content of the data memory */
 void sim_ooo::print_memory(unsigned start_address, unsigned end_address){
-	cout << "DATA MEMORY[0x" << hex << setw(8) << setfill('0') << start_address << ":0x" << hex << setw(8) << setfill('0') <<  end_address << "]" << endl;
+	ostream &out = *output;
+	out << "DATA MEMORY[0x" << hex << setw(8) << setfill('0') << start_address << ":0x" << hex << setw(8) << setfill('0') <<  end_address << "]" << endl;
+	unsigned word = 0;
 	for (unsigned i=start_address; i<end_address; i++){
-		if (i%4 == 0) cout << "0x" << hex << setw(8) << setfill('0') << i << ": "; 
-		cout << hex << setw(2) << setfill('0') << int(data_memory[i]) << " ";
+		if (i%4 == 0 || i == start_address) word = data_memory.load_word(i & ~3u);
+		if (i%4 == 0) out << "0x" << hex << setw(8) << setfill('0') << i << ": "; 
+		out << hex << setw(2) << setfill('0') << int((word >> (8*(i%4))) & 0xFF) << " ";
 		if (i%4 == 3){
-			cout << endl;
+			out << endl;
 		}
 	} 
 }
 
 /* prints the value of the registers */
 void sim_ooo::print_registers(){
+	ostream &out = *output;
         unsigned i;
-	cout << "GENERAL PURPOSE REGISTERS" << endl;
-	cout << setfill(' ') << setw(8) << "Register" << setw(22) << "Value" << setw(5) << "ROB" << endl;
+	out << "GENERAL PURPOSE REGISTERS" << endl;
+	out << setfill(' ') << setw(8) << "Register" << setw(22) << "Value" << setw(5) << "ROB" << endl;
         for (i=0; i< NUM_GP_REGISTERS; i++){
                 if (get_int_register_tag(i)!=UNDEFINED) 
-			cout << setfill(' ') << setw(7) << "R" << dec << i << setw(22) << "-" << setw(5) << get_int_register_tag(i) << endl;
+			out << setfill(' ') << setw(7) << "R" << dec << i << setw(22) << "-" << setw(5) << get_int_register_tag(i) << endl;
                 else if (get_int_register(i)!=(int)UNDEFINED) 
-			cout << setfill(' ') << setw(7) << "R" << dec << i << setw(11) << get_int_register(i) << hex << "/0x" << setw(8) << setfill('0') << get_int_register(i) << setfill(' ') << setw(5) << "-" << endl;
+			out << setfill(' ') << setw(7) << "R" << dec << i << setw(11) << get_int_register(i) << hex << "/0x" << setw(8) << setfill('0') << get_int_register(i) << setfill(' ') << setw(5) << "-" << endl;
         }
 	for (i=0; i< NUM_GP_REGISTERS; i++){
                 if (get_fp_register_tag(i)!=UNDEFINED) 
-			cout << setfill(' ') << setw(7) << "F" << dec << i << setw(22) << "-" << setw(5) << get_fp_register_tag(i) << endl;
-                else if (float2unsigned(get_fp_register(i)) != UNDEFINED)
-			cout << setfill(' ') << setw(7) << "F" << dec << i << setw(11) << get_fp_register(i) << hex << "/0x" << setw(8) << setfill('0') << float2unsigned(get_fp_register(i)) << setfill(' ') << setw(5) << "-" << endl;
+			out << setfill(' ') << setw(7) << "F" << dec << i << setw(22) << "-" << setw(5) << get_fp_register_tag(i) << endl;
+                else if (float2bits(get_fp_register(i)) != UNDEFINED)
+			out << setfill(' ') << setw(7) << "F" << dec << i << setw(11) << get_fp_register(i) << hex << "/0x" << setw(8) << setfill('0') << float2bits(get_fp_register(i)) << setfill(' ') << setw(5) << "-" << endl;
 	}
-	cout << endl;
+	out << endl;
 }
 
 /* prints the content of the ROB */
 void sim_ooo::print_rob(){
-	cout << "REORDER BUFFER" << endl;
-	cout << setfill(' ') << setw(5) << "Entry" << setw(6) << "Busy" << setw(7) << "Ready" << setw(12) << "PC" << setw(10) << "State" << setw(6) << "Dest" << setw(12) << "Value" << endl;
+	ostream &out = *output;
+	out << "REORDER BUFFER" << endl;
+	out << setfill(' ') << setw(5) << "Entry" << setw(6) << "Busy" << setw(7) << "Ready" << setw(12) << "PC" << setw(10) << "State" << setw(6) << "Dest" << setw(12) << "Value" << endl;
 	for(unsigned i=0; i< rob->num_entries;i++){
 		rob_entry_t entry = rob->entries[i];
 		instruction_t instruction;
 		if (entry.pc != UNDEFINED) instruction = instr_memory[(entry.pc-instr_base_address)>>2]; 
-		cout << setfill(' ');
-		cout << setw(5) << i;
-		cout << setw(6);
-		if (entry.pc==UNDEFINED) cout << "no"; else cout << "yes";
-		cout << setw(7);
-		if (entry.ready) cout << "yes"; else cout << "no";	
-		if (entry.pc!= UNDEFINED ) cout << "  0x" << hex << setfill('0') << setw(8) << entry.pc;
-		else	cout << setw(12) << "-";
-		cout << setfill(' ') << setw(10);
-		if (entry.pc==UNDEFINED) cout << "-";		
-		else cout << stage_names[entry.state];
-		if (entry.destination==UNDEFINED) cout << setw(6) << "-";
+		out << setfill(' ');
+		out << setw(5) << i;
+		out << setw(6);
+		if (entry.pc==UNDEFINED) out << "no"; else out << "yes";
+		out << setw(7);
+		if (entry.ready) out << "yes"; else out << "no";	
+		if (entry.pc!= UNDEFINED ) out << "  0x" << hex << setfill('0') << setw(8) << entry.pc;
+		else	out << setw(12) << "-";
+		out << setfill(' ') << setw(10);
+		if (entry.pc==UNDEFINED) out << "-";		
+		else out << stage_names[entry.state];
+		if (entry.destination==UNDEFINED) out << setw(6) << "-";
 		else{
 			if (instruction.opcode == SW || instruction.opcode == SWS)
-				cout << setw(6) << dec << entry.destination; 
+				out << setw(6) << dec << entry.destination; 
 			else if (entry.destination < NUM_GP_REGISTERS && (!isOpcodeFpType(instruction.opcode)))
-				cout << setw(5) << "R" << dec << entry.destination;
+				out << setw(5) << "R" << dec << entry.destination;
 			else
-				cout << setw(5) << "F" << dec << entry.destination;
+				out << setw(5) << "F" << dec << entry.destination;
 		}
-		if (entry.value!=UNDEFINED) cout << "  0x" << hex << setw(8) << setfill('0') << entry.value << endl;	
-		else cout << setw(12) << setfill(' ') << "-" << endl;
+		if (entry.value!=UNDEFINED) out << "  0x" << hex << setw(8) << setfill('0') << entry.value << endl;	
+		else out << setw(12) << setfill(' ') << "-" << endl;
 	}
-	cout << endl;
+	out << endl;
 }
 
 /* prints the content of the reservation stations */
 void sim_ooo::print_reservation_stations(){
-	cout << "RESERVATION STATIONS" << endl;
-	cout  << setfill(' ');
-	cout << setw(7) << "Name" << setw(6) << "Busy" << setw(12) << "PC" << setw(12) << "Vj" << setw(12) << "Vk" << setw(6) << "Qj" << setw(6) << "Qk" << setw(6) << "Dest" << setw(12) << "Address" << endl; 
+	ostream &out = *output;
+	out << "RESERVATION STATIONS" << endl;
+	out  << setfill(' ');
+	out << setw(7) << "Name" << setw(6) << "Busy" << setw(12) << "PC" << setw(12) << "Vj" << setw(12) << "Vk" << setw(6) << "Qj" << setw(6) << "Qk" << setw(6) << "Dest" << setw(12) << "Address" << endl; 
 	for(unsigned i=0; i< reservation_stations->num_entries;i++){
 		res_station_entry_t entry = reservation_stations->entries[i];
-	 	cout  << setfill(' ');
-		cout << setw(6); 
-		cout << res_station_names[entry.type];
-		cout << entry.name + 1;
-		cout << setw(6);
-		if (entry.pc==UNDEFINED) cout << "no"; else cout << "yes";
-		if (entry.pc!= UNDEFINED ) cout << setw(4) << "  0x" << hex << setfill('0') << setw(8) << entry.pc;
-		else	cout << setfill(' ') << setw(12) <<  "-";			
-		if (entry.value1!= UNDEFINED ) cout << "  0x" << setfill('0') << setw(8) << hex << entry.value1;
-		else	cout << setfill(' ') << setw(12) << "-";			
-		if (entry.value2!= UNDEFINED ) {
-            if(isLoadInstr(entry.entry_instr.opcode))
+	 	out  << setfill(' ');
+		out << setw(6); 
+		out << res_station_names[reservation_stations->type[i]];
+		out << entry.name + 1;
+		out << setw(6);
+		if (entry.pc==UNDEFINED) out << "no"; else out << "yes";
+		if (entry.pc!= UNDEFINED ) out << setw(4) << "  0x" << hex << setfill('0') << setw(8) << entry.pc;
+		else	out << setfill(' ') << setw(12) <<  "-";			
+		if (reservation_stations->value1[i]!= UNDEFINED ) out << "  0x" << setfill('0') << setw(8) << hex << reservation_stations->value1[i];
+		else	out << setfill(' ') << setw(12) << "-";			
+		if (reservation_stations->value2[i]!= UNDEFINED ) {
+            if(entry.entry_instr->flags & INSTR_LOAD)
             {
-                if((entry.CDBWriteDataAvailClkCycle+1) < (int)(currClkCycle))
+                if((reservation_stations->CDBWriteDataAvailClkCycle[i]+1) < (long long)(current_cycle))
                 {
-                    cout << "  0x" << setfill('0') << setw(8) << hex << entry.value2;
+                    out << "  0x" << setfill('0') << setw(8) << hex << reservation_stations->value2[i];
                 }else
                 {
-                    cout << setfill(' ') << setw(12) << "-";
+                    out << setfill(' ') << setw(12) << "-";
                 }
             }else {
-                cout << "  0x" << setfill('0') << setw(8) << hex << entry.value2;
+                out << "  0x" << setfill('0') << setw(8) << hex << reservation_stations->value2[i];
             }
         }
-		else	cout << setfill(' ') << setw(12) << "-";			
-		cout << setfill(' ');
-		cout <<setw(6);
-		if (entry.tag1!= UNDEFINED ) cout << dec << entry.tag1;
-		else	cout << "-";			
-		cout <<setw(6);
-		if (entry.tag2!= UNDEFINED ) cout << dec << entry.tag2;
-		else	cout << "-";			
-		cout <<setw(6);
-		if (entry.destination!= UNDEFINED ) cout << dec << entry.destination;
-		else	cout << "-";			
-		if (entry.address != UNDEFINED ) cout <<setw(4) << "  0x" << setfill('0') << setw(8) << hex << entry.address;
-		else	cout << setfill(' ') << setw(12) <<  "-";			
-		cout << endl;	
+		else	out << setfill(' ') << setw(12) << "-";			
+		out << setfill(' ');
+		out <<setw(6);
+		if (reservation_stations->tag1[i]!= UNDEFINED ) out << dec << reservation_stations->tag1[i];
+		else	out << "-";			
+		out <<setw(6);
+		if (reservation_stations->tag2[i]!= UNDEFINED ) out << dec << reservation_stations->tag2[i];
+		else	out << "-";			
+		out <<setw(6);
+		if (entry.destination!= UNDEFINED ) out << dec << entry.destination;
+		else	out << "-";			
+		if (entry.address != UNDEFINED ) out <<setw(4) << "  0x" << setfill('0') << setw(8) << hex << entry.address;
+		else	out << setfill(' ') << setw(12) <<  "-";			
+		out << endl;	
 	}
-	cout << endl;
+	out << endl;
 }
 
 /* prints the state of the pending instructions */
 void sim_ooo::print_pending_instructions(){
-	cout << "PENDING INSTRUCTIONS STATUS" << endl;
-	cout << setfill(' ');
-	cout << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit";
-	cout << endl;
+	ostream &out = *output;
+	out << "PENDING INSTRUCTIONS STATUS" << endl;
+	out << setfill(' ');
+	out << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit";
+	out << endl;
 	for(unsigned i=0; i< pending_instructions.num_entries;i++){
 		instr_window_entry_t entry = pending_instructions.entries[i];
-		if (entry.pc!= UNDEFINED ) cout << "0x" << setfill('0') << setw(8) << hex << entry.pc;
-		else	cout << setfill(' ') << setw(10)  << "-";
-		cout << setfill(' ');
-		cout << setw(7);			
-		if (entry.issue!= UNDEFINED ) cout << dec << entry.issue;
-		else	cout << "-";			
-		cout << setw(7);			
-		if (entry.exe!= UNDEFINED ) cout << dec << entry.exe;
-		else	cout << "-";			
-		cout << setw(7);			
-		if (entry.wr!= UNDEFINED ) cout << dec << entry.wr;
-		else	cout << "-";			
-		cout << setw(7);			
-		if (entry.commit!= UNDEFINED ) cout << dec << entry.commit;
-		else	cout << "-";
-		cout << endl;			
+		if (entry.pc!= UNDEFINED ) out << "0x" << setfill('0') << setw(8) << hex << entry.pc;
+		else	out << setfill(' ') << setw(10)  << "-";
+		out << setfill(' ');
+		out << setw(7);			
+		if (entry.issue!= UNDEFINED_CYCLE ) out << dec << entry.issue;
+		else	out << "-";			
+		out << setw(7);			
+		if (entry.exe!= UNDEFINED_CYCLE ) out << dec << entry.exe;
+		else	out << "-";			
+		out << setw(7);			
+		if (entry.wr!= UNDEFINED_CYCLE ) out << dec << entry.wr;
+		else	out << "-";			
+		out << setw(7);			
+		if (entry.commit!= UNDEFINED_CYCLE ) out << dec << entry.commit;
+		else	out << "-";
+		out << endl;			
 	}
-	cout << endl;
+	out << endl;
 }
 
 
-/* initializes the execution log */
-void sim_ooo::init_log(){
+/* prints the header of the execution log */
+void print_log_header(ostream &log){
 	log << "EXECUTION LOG" << endl;
 	log << setfill(' ');
 	log << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit";
 	log << endl;
 }
 
-/* adds an instruction to the log */
-void sim_ooo::commit_to_log(instr_window_entry_t entry){
+/* prints an instruction of the execution log */
+void print_log_entry(ostream &log, const instr_window_entry_t &entry){
                 if (entry.pc!= UNDEFINED ) log << "0x" << setfill('0') << setw(8) << hex << entry.pc;
                 else    log << setfill(' ') << setw(10)  << "-";
                 log << setfill(' ');
                 log << setw(7);
-                if (entry.issue!= UNDEFINED ) log << dec << entry.issue;
+                if (entry.issue!= UNDEFINED_CYCLE ) log << dec << entry.issue;
                 else    log << "-";
                 log << setw(7);
-                if (entry.exe!= UNDEFINED ) log << dec << entry.exe;
+                if (entry.exe!= UNDEFINED_CYCLE ) log << dec << entry.exe;
                 else    log << "-";
                 log << setw(7);
-                if (entry.wr!= UNDEFINED ) log << dec << entry.wr;
+                if (entry.wr!= UNDEFINED_CYCLE ) log << dec << entry.wr;
                 else    log << "-";
                 log << setw(7);
-                if (entry.commit!= UNDEFINED ) log << dec << entry.commit;
+                if (entry.commit!= UNDEFINED_CYCLE ) log << dec << entry.commit;
                 else    log << "-";
                 log << endl;
 }
 
+/* initializes the execution log */
+void sim_ooo::init_log(){
+	print_log_header(log);
+}
+
+/* adds an instruction to the log */
+void sim_ooo::commit_to_log(instr_window_entry_t entry){
+	HOST_PROFILE_SCOPE(this, HOST_LOG);
+	if (log_writer != NULL) log_writer->append(entry);
+	else print_log_entry(log, entry);
+	if (pipeview != NULL) pipeview->append(entry, isValidPC(entry.pc) ? &instr_memory[(entry.pc - instr_base_address)/4] : NULL);
+	if (profile != NULL && isValidPC(entry.pc)) profile->record((entry.pc - instr_base_address)/4, entry);
+}
+
 /* prints the content of the log */
 void sim_ooo::print_log(){
-	cout << log.str();
+	*output << log.str();
+	if (log_writer != NULL){
+		//the binary log is decoded back from its file
+		log_writer->flush();
+		ifstream fin(log_writer->filename.c_str(), ios::in | ios::binary);
+		decode_log(fin, *output, false);
+	}
+}
+
+void sim_ooo::set_log_file(const char *filename){
+	delete log_writer;
+	log_writer = new Log_Writer(filename);
+}
+
+void sim_ooo::set_pipeview_file(const char *filename){
+	delete pipeview;
+	pipeview = new Pipeview_Writer(filename);
+}
+
+void sim_ooo::enable_profile(){
+	if (profile == NULL) profile = new Instruction_Profile();
+	else profile->clear();
+}
+
+void sim_ooo::print_profile(){
+	Instruction_Profile empty;
+	(profile != NULL ? profile : &empty)->print(*output, loaded_image, instr_memory, instr_memory_size, instr_base_address);
 }
 
 /* prints the state of the pending instruction, the content of the ROB, the content of the reservation stations and of the registers */
@@ -478,9 +901,49 @@ void sim_ooo::print_status(){
 
 float sim_ooo::get_IPC(){return (float)instructions_executed/clock_cycles;}
 
-unsigned sim_ooo::get_instructions_executed(){return instructions_executed;}
+unsigned long long sim_ooo::get_instructions_executed(){return instructions_executed;}
 
-unsigned sim_ooo::get_clock_cycles(){return clock_cycles;}
+unsigned long long sim_ooo::get_clock_cycles(){return clock_cycles;}
+
+perf_counters_t sim_ooo::get_perf_counters(){return counters;}
+
+void sim_ooo::account_cycles(unsigned long long cycles){
+	//a cycle that committed is useful work; otherwise the pipeline refill after a squash comes
+	//first, then what held the oldest instruction stalled, then what stopped issue
+	unsigned component;
+	if (cycle_commit) component = CPI_BASE;
+	else if (flushing) component = CPI_BRANCH_FLUSH;
+	else if (cycle_stall_age != UNDEFINED) component = cycle_stall;
+	else component = cycle_issue_stall;
+	counters.cycles[component] += cycles;
+	for (unsigned mask = cycle_event_mask; mask != 0; mask &= mask - 1){
+		unsigned e = __builtin_ctz(mask);
+		counters.events[e] += cycles * cycle_events[e];
+	}
+}
+
+void sim_ooo::print_cpi_stack(){
+	ostream &out = *output;
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	unsigned long long cycles = 0;
+	for (unsigned c=0; c<NUM_CPI_COMPONENTS; c++) cycles += counters.cycles[c];
+	out << "CPI STACK" << endl;
+	out << "instructions: " << instructions_executed << "  cycles: " << cycles << "  CPI: " << fixed << setprecision(3)
+	    << (instructions_executed ? (double)cycles / instructions_executed : 0) << endl;
+	out << setfill(' ') << left << setw(22) << "component" << right << setw(14) << "cycles" << setw(10) << "CPI" << setw(9) << "share" << endl;
+	for (unsigned c=0; c<NUM_CPI_COMPONENTS; c++){
+		out << left << setw(22) << cpi_component_names[c] << right << setw(14) << counters.cycles[c]
+		    << setw(10) << setprecision(3) << (instructions_executed ? (double)counters.cycles[c] / instructions_executed : 0)
+		    << setw(8) << setprecision(1) << (cycles ? 100.0 * counters.cycles[c] / cycles : 0) << "%" << endl;
+	}
+	out << endl << "STALL EVENTS" << endl;
+	for (unsigned e=0; e<NUM_STALL_EVENTS; e++)
+		out << left << setw(22) << stall_event_names[e] << right << setw(14) << counters.events[e] << endl;
+	out << endl;
+	out.flags(flags);
+	out.precision(precision);
+}
 
 
 
@@ -491,16 +954,72 @@ unsigned sim_ooo::get_clock_cycles(){return clock_cycles;}
    =========================================================================== */
 
 
-void sim_ooo::load_program(const char *filename, unsigned base_address){
+/* an EOP instruction, with all its fields undefined */
+static instruction_t eop_instruction(){
+	instruction_t instr;
+	instr.opcode=(opcode_t)EOP;
+	instr.src1=UNDEFINED;
+	instr.src2=UNDEFINED;
+	instr.dest=UNDEFINED;
+	instr.immediate=UNDEFINED;
+	instr.target=UNDEFINED;
+	instr.flags=0;
+	instr.unit=UNDEFINED_UNIT;
+	instr.station=MAX_RS;
+	return instr;
+}
+
+void clear_program_image(program_image_t *image){
+	image->instructions.assign(1, eop_instruction());
+	image->branch_labels.clear();
+	image->data.clear();
+	image->source.clear();
+	image->source_line.clear();
+	image->base_address = 0;
+}
+
+/* appends a little-endian word to the data segments of a program image, at the location counter */
+static void append_data_word(program_image_t *image, unsigned *address, unsigned value){
+	vector<data_segment_t> &data = image->data;
+	if (data.empty() || data.back().address + data.back().bytes.size() != *address){
+		data.push_back(data_segment_t());
+		data.back().address = *address;
+	}
+	for (unsigned b=0; b<4; b++) data.back().bytes.push_back((value >> (8*b)) & 0xFF);
+	*address += 4;
+}
+
+/* parses the operands of a data directive (see parse_program) */
+static void parse_directive(const char *token, char **line_state, program_image_t *image, unsigned *address){
+	string directive = string(token).substr(0, strcspn(token, "\r"));
+	char *value;
+	if (directive == ".data"){
+		value = strtok_r(NULL, " \t,\r", line_state);
+		if (value != NULL) *address = strtoul(value, NULL, 0);
+	} else if (directive == ".space"){
+		value = strtok_r(NULL, " \t,\r", line_state);
+		if (value == NULL) cout << "ERROR: missing size of .space !" << endl;
+		else *address += strtoul(value, NULL, 0);
+	} else if (directive == ".word" || directive == ".float"){
+		while ((value = strtok_r(NULL, " \t,\r", line_state)) != NULL){
+			if (directive == ".word") append_data_word(image, address, (unsigned)strtoll(value, NULL, 0));
+			else append_data_word(image, address, float2bits(strtof(value, NULL)));
+		}
+	} else {
+		cout << "ERROR: invalid directive: " << directive << " !" << endl;
+	}
+}
+
+void parse_program(const char *filename, unsigned base_address, program_image_t *image){
+
+   unordered_map<unsigned, string> &branch_labels = image->branch_labels;
+   clear_program_image(image);
 
    /* initializing the base instruction address */
-   instr_base_address = base_address;
-    mBaseAddr = instr_base_address;
-    PC = instr_base_address;
-    mInstrMemPtr = instr_memory;
-   /* creating a map with the valid opcodes and with the valid labels */
-   map<string, opcode_t> opcodes; //for opcodes
-   map<string, unsigned> labels;  //for branches
+   image->base_address = base_address;
+   /* creating hash tables with the valid opcodes and with the valid labels */
+   unordered_map<string, opcode_t> opcodes; //for opcodes
+   unordered_map<string, unsigned> labels;  //for branches
    for (int i=0; i<NUM_OPCODES; i++)
 	 opcodes[string(instr_names[i])]=(opcode_t)i;
 
@@ -511,28 +1030,47 @@ void sim_ooo::load_program(const char *filename, unsigned base_address){
       exit(-1);
    }
 
-   /* parsing the assembly file line by line */
+   /* sizing the instruction memory: at most one instruction per line, followed by an EOP */
+   vector<string> lines;
    string line;
+   while (getline(fin,line)) lines.push_back(line);
+   image->instructions.assign(lines.size() + 1, eop_instruction());
+   image->source_line.assign(lines.size() + 1, UNDEFINED);
+   instruction_t *instr_memory = &image->instructions[0];
+   labels.reserve(lines.size());
+
+   /* parsing the assembly file line by line */
    unsigned instruction_nr = 0;
-   while (getline(fin,line)){
+   unsigned data_address = 0; //location counter of the data directives
+   for (unsigned line_nr = 0; line_nr < lines.size(); line_nr++){
+	line = lines[line_nr];
 	
 	// set the instruction field
 	char *str = const_cast<char*>(line.c_str());
+	// strtok_r keeps the tokenizer state local, so programs can be loaded concurrently
+	char *line_state;
+	char *field_state;
 
   	// tokenize the instruction
-	char *token = strtok (str," \t");
-	map<string, opcode_t>::iterator search = opcodes.find(token);
+	char *token = strtok_r(str, " \t", &line_state);
+	if (token == NULL) continue;
+	if (token[0] == '.'){
+		parse_directive(token, &line_state, image, &data_address);
+		continue;
+	}
+	unordered_map<string, opcode_t>::iterator search = opcodes.find(token);
         if (search == opcodes.end()){
 		// this is a label for a branch - extract it and save it in the labels map
 		string label = string(token).substr(0, string(token).length() - 1);
 		labels[label]=instruction_nr;
 		// move to next token, which must be the instruction opcode
-		token = strtok (NULL, " \t");
+		token = strtok_r(NULL, " \t", &line_state);
 		search = opcodes.find(token);
 		if (search == opcodes.end()) cout << "ERROR: invalid opcode: " << token << " !" << endl;
 	}
 
 	instr_memory[instruction_nr].opcode = search->second;
+	image->source_line[instruction_nr] = line_nr;
 
 	//reading remaining parameters
 	char *par1;
@@ -549,37 +1087,37 @@ void sim_ooo::load_program(const char *filename, unsigned base_address){
 		case SUBS:
 		case MULTS:
 		case DIVS:
-			par1 = strtok (NULL, " \t");
-			par2 = strtok (NULL, " \t");
-			par3 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].src1 = atoi(strtok(par2, "RF"));
-			instr_memory[instruction_nr].src2 = atoi(strtok(par3, "RF"));
+			par1 = strtok_r(NULL, " \t", &line_state);
+			par2 = strtok_r(NULL, " \t", &line_state);
+			par3 = strtok_r(NULL, " \t", &line_state);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "RF", &field_state));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "RF", &field_state));
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(par3, "RF", &field_state));
 			break;
 		case ADDI:
 		case SUBI:
-			par1 = strtok (NULL, " \t");
-			par2 = strtok (NULL, " \t");
-			par3 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "R"));
-			instr_memory[instruction_nr].src1 = atoi(strtok(par2, "R"));
+			par1 = strtok_r(NULL, " \t", &line_state);
+			par2 = strtok_r(NULL, " \t", &line_state);
+			par3 = strtok_r(NULL, " \t", &line_state);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "R", &field_state));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "R", &field_state));
 			instr_memory[instruction_nr].immediate = strtoul (par3, NULL, 0); 
 			break;
 		case LW:
 		case LWS:
-			par1 = strtok (NULL, " \t");
-			par2 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].immediate = strtoul(strtok(par2, "()"), NULL, 0);
-			instr_memory[instruction_nr].src1 = atoi(strtok(NULL, "R"));
+			par1 = strtok_r(NULL, " \t", &line_state);
+			par2 = strtok_r(NULL, " \t", &line_state);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "RF", &field_state));
+			instr_memory[instruction_nr].immediate = strtoul(strtok_r(par2, "()", &field_state), NULL, 0);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(NULL, "R", &field_state));
 			break;
 		case SW:
 		case SWS:
-			par1 = strtok (NULL, " \t");
-			par2 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].src1 = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].immediate = strtoul(strtok(par2, "()"), NULL, 0);
-			instr_memory[instruction_nr].src2 = atoi(strtok(NULL, "R"));
+			par1 = strtok_r(NULL, " \t", &line_state);
+			par2 = strtok_r(NULL, " \t", &line_state);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par1, "RF", &field_state));
+			instr_memory[instruction_nr].immediate = strtoul(strtok_r(par2, "()", &field_state), NULL, 0);
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(NULL, "R", &field_state));
 			break;
 		case BEQZ:
 		case BNEZ:
@@ -587,39 +1125,135 @@ void sim_ooo::load_program(const char *filename, unsigned base_address){
 		case BGTZ:
 		case BLEZ:
 		case BGEZ:
-			par1 = strtok (NULL, " \t");
-			par2 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].src1 = atoi(strtok(par1, "R"));
-			instr_memory[instruction_nr].label = par2;
+			par1 = strtok_r(NULL, " \t", &line_state);
+			par2 = strtok_r(NULL, " \t", &line_state);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par1, "R", &field_state));
+			branch_labels[instruction_nr] = par2;
 			break;
 		case JUMP:
-			par2 = strtok (NULL, " \t");
-			instr_memory[instruction_nr].label = par2;
+			par2 = strtok_r(NULL, " \t", &line_state);
+			branch_labels[instruction_nr] = par2;
 		default:
 			break;
 
 	} 
-
-	/* increment instruction number before moving to next line */
 	instruction_nr++;
    }
+   image->instructions.resize(instruction_nr + 1);
+   image->source_line.resize(instruction_nr + 1);
+   image->source_line[instruction_nr] = UNDEFINED;
+   image->source.swap(lines);
+   instr_memory = &image->instructions[0];
    //reconstructing the labels of the branch operations
-   int i = 0;
+   unsigned i = 0;
    while(true){
-   	instruction_t instr = instr_memory[i];
+   	instruction_t &instr = instr_memory[i];
 	if (instr.opcode == EOP) break;
 	if (instr.opcode == BLTZ || instr.opcode == BNEZ ||
             instr.opcode == BGTZ || instr.opcode == BEQZ ||
             instr.opcode == BGEZ || instr.opcode == BLEZ ||
             instr.opcode == JUMP
 	 ){
-		instr_memory[i].immediate = (labels[instr.label] - i - 1) << 2;
+		unordered_map<string, unsigned>::iterator target = labels.find(branch_labels[i]);
+		if (target == labels.end()) cout << "ERROR: undefined label: " << branch_labels[i] << " !" << endl;
+		else instr.immediate = (target->second - i - 1) << 2;
 	}
+	predecode(&instr, base_address + 4*i);
         i++;
    }
 
 }
 
+/* returns the assembly text of a predecoded instruction (branch targets as addresses) */
+string disassemble(const instruction_t &instr){
+	char text[64];
+	const char *name = instr_names[instr.opcode];
+	char reg = (instr.flags & INSTR_FP) ? 'F' : 'R';
+	switch(instr.opcode){
+		case LW:
+		case LWS:
+			snprintf(text, sizeof text, "%s %c%u %d(R%u)", name, reg, instr.dest, (int)instr.immediate, instr.src1);
+			break;
+		case SW:
+		case SWS:
+			snprintf(text, sizeof text, "%s %c%u %d(R%u)", name, reg, instr.src1, (int)instr.immediate, instr.src2);
+			break;
+		case ADDI:
+		case SUBI:
+			snprintf(text, sizeof text, "%s R%u R%u %d", name, instr.dest, instr.src1, (int)instr.immediate);
+			break;
+		case BEQZ:
+		case BNEZ:
+		case BLTZ:
+		case BGTZ:
+		case BLEZ:
+		case BGEZ:
+			snprintf(text, sizeof text, "%s R%u 0x%08x", name, instr.src1, instr.target);
+			break;
+		case JUMP:
+			snprintf(text, sizeof text, "%s 0x%08x", name, instr.target);
+			break;
+		case EOP:
+			snprintf(text, sizeof text, "%s", name);
+			break;
+		default:
+			snprintf(text, sizeof text, "%s %c%u %c%u %c%u", name, reg, instr.dest, reg, instr.src1, reg, instr.src2);
+			break;
+	}
+	return string(text);
+}
+
+void sim_ooo::load_program(const char *filename, unsigned base_address){
+	parse_program(filename, base_address, &program);
+	load_program(program);
+}
+
+void sim_ooo::load_program(const program_image_t &image){
+	delete interpreter;
+	interpreter = NULL;
+	if (profile != NULL) profile->clear();
+	loaded_image = &image;
+	instr_memory = &image.instructions[0];
+	instr_memory_size = image.instructions.size();
+	instr_base_address = image.base_address;
+	rob->map_program(instr_memory_size);
+	PC = instr_base_address;
+
+	//initial content of the data memory
+	for (unsigned i=0; i<image.data.size(); i++){
+		const data_segment_t &segment = image.data[i];
+		if (segment.address > data_memory_size || segment.bytes.size() > data_memory_size - segment.address){
+			cout << "ERROR:: data segment at 0x" << hex << segment.address << " does not fit in the data memory!\n";
+			exit(-1);
+		}
+		data_memory.store_bytes(segment.address, &segment.bytes[0], segment.bytes.size());
+	}
+}
+
+void sim_ooo::load_memory_image(const char *filename, unsigned base_address){
+	int fd = open(filename, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) < 0){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	if (base_address > data_memory_size || (unsigned long long)info.st_size > data_memory_size - base_address){
+		cout << "ERROR:: memory image " << filename << " does not fit in the data memory!\n";
+		exit(-1);
+	}
+	if (info.st_size > 0){
+		unsigned char *image = (unsigned char *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (image == MAP_FAILED){
+			cerr << "error: map file " << filename << " failed!" << endl;
+			exit(-1);
+		}
+		madvise(image, info.st_size, MADV_SEQUENTIAL);
+		data_memory.store_bytes(base_address, image, info.st_size);
+		munmap(image, info.st_size);
+	}
+	close(fd);
+}
+
 /* ============================================================================
 
    Simulator creation, initialization and deallocation 
@@ -633,22 +1267,21 @@ sim_ooo::sim_ooo(unsigned mem_size,
                 unsigned num_mul_res_stations,
                 unsigned num_load_res_stations,
 		unsigned max_issue){
-    currSim = this;
 	//memory
 	data_memory_size = mem_size;
-    mDataMemSize = data_memory_size;
-	data_memory = new unsigned char[data_memory_size];
+	data_memory.init(data_memory_size);
 
 	//issue width
 	issue_width = max_issue;
 
 	//rob, instruction window, reservation stations
-    rob = new ROB(rob_size);
+    rob = new ROB(rob_size, this);
 	//rob->num_entries=rob_size;
 	pending_instructions.num_entries=rob_size;
-    reservation_stations = new Reservation_Stations(num_int_res_stations,num_load_res_stations,num_add_res_stations,num_mul_res_stations);
+    reservation_stations = new Reservation_Stations(num_int_res_stations,num_load_res_stations,num_add_res_stations,num_mul_res_stations,this);
     for(int i=0; i<reservation_stations->num_entries;i++)
-        clean_res_station(&reservation_stations->entries[i]);
+        reservation_stations->clean(i);
+    lsq = new Load_Store_Queue(rob_size, this);
     //reservation_stations->num_entries= num_int_res_stations+num_load_res_stations+num_add_res_stations+num_mul_res_stations;
 	//rob->entries = new rob_entry_t[rob_size];
 
@@ -658,6 +1291,36 @@ sim_ooo::sim_ooo(unsigned mem_size,
 
 	//execution units
 	num_units = 0;
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++) free_units[u] = 0;
+	num_dummy_units = 0;
+	curr_dummy_unit = 0;
+	output = &cout;
+
+	//every ROB entry, station and unit can be pending release at the same time
+	release_queue = new release_entry_t[rob_size + reservation_stations->num_entries + MAX_UNITS];
+	release_count = 0;
+	event_driven = true;
+	latency_watch = 0;
+	latency_diverged = false;
+	trace = NULL;
+	trace_consumer = 0;
+	trace_records = NULL;
+	trace_wrong_path = 0;
+	log_writer = NULL;
+	pipeview = NULL;
+	profile = NULL;
+	host_profile = NULL;
+	interpreter = NULL;
+	instruction_limit = UNDEFINED_CYCLE;
+	draining = false;
+	cycle_progress = false;
+	redirect_pc = UNDEFINED;
+	cycle_commit = false;
+	cycle_stall = CPI_BASE;
+	cycle_stall_age = UNDEFINED;
+	cycle_issue_stall = CPI_BASE;
+	memset(cycle_events, 0, sizeof cycle_events);
+	cycle_event_mask = 0;
 
     for(int i=0;i<NUM_GP_REGISTERS;i++)
     {
@@ -670,12 +1333,236 @@ sim_ooo::sim_ooo(unsigned mem_size,
 	reset();
 }
 	
+sim_ooo::sim_ooo(const sim_ooo &other){
+	if (other.trace != NULL){
+		cout << "ERROR:: a simulator reading a functional trace cannot be copied!\n";
+		exit(-1);
+	}
+	if (other.log_writer != NULL){
+		cout << "ERROR:: a simulator writing a binary log cannot be copied!\n";
+		exit(-1);
+	}
+	if (other.pipeview != NULL){
+		cout << "ERROR:: a simulator writing a pipeline trace cannot be copied!\n";
+		exit(-1);
+	}
+	for (unsigned i=0; i<NUM_GP_REGISTERS; i++){
+		int_reg_file[i] = other.int_reg_file[i];
+		fp_reg_file[i] = other.fp_reg_file[i];
+	}
+	PC = other.PC;
+	issue_width = other.issue_width;
+
+	//rob, instruction window, reservation stations
+	rob = new ROB(*other.rob, this);
+	pending_instructions.num_entries = other.pending_instructions.num_entries;
+	pending_instructions.entries = copy_array(other.pending_instructions.entries, pending_instructions.num_entries);
+	reservation_stations = new Reservation_Stations(*other.reservation_stations, this);
+	lsq = new Load_Store_Queue(*other.lsq, this);
+
+	//execution units
+	num_units = other.num_units;
+	num_dummy_units = other.num_dummy_units;
+	curr_dummy_unit = other.curr_dummy_unit;
+	for (unsigned u=0; u<MAX_UNITS; u++){
+		exec_units[u] = other.exec_units[u];
+		dummy_units[u] = other.dummy_units[u];
+	}
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++) free_units[u] = other.free_units[u];
+	current_cycle = other.current_cycle;
+	release_queue = copy_array(other.release_queue, rob->num_entries + reservation_stations->num_entries + MAX_UNITS);
+	release_count = other.release_count;
+	wheel.copy(other.wheel);
+	event_driven = other.event_driven;
+	latency_watch = other.latency_watch;
+	latency_diverged = other.latency_diverged;
+	trace = NULL;
+	trace_consumer = 0;
+	trace_records = NULL;
+	trace_wrong_path = 0;
+	log_writer = NULL;
+	pipeview = NULL;
+	profile = (other.profile != NULL) ? new Instruction_Profile(*other.profile) : NULL;
+	host_profile = NULL;
+	interpreter = NULL;
+	instruction_limit = other.instruction_limit;
+	draining = other.draining;
+	cycle_progress = other.cycle_progress;
+	redirect_pc = other.redirect_pc;
+
+	//a shared program image is shared by the copy too; the pipeline pointers into a private one
+	//are moved to the copy of the image
+	program = other.program;
+	instr_base_address = other.instr_base_address;
+	instr_memory_size = other.instr_memory_size;
+	loaded_image = (other.loaded_image == &other.program) ? &program : other.loaded_image;
+	if (other.instr_memory == &other.program.instructions[0]){
+		instr_memory = &program.instructions[0];
+		for (unsigned i=0; i<rob->num_entries; i++)
+			if (rob->entries[i].entry_instr != NULL) rob->entries[i].entry_instr = instr_memory + (rob->entries[i].entry_instr - other.instr_memory);
+		for (unsigned i=0; i<reservation_stations->num_entries; i++)
+			if (reservation_stations->entries[i].entry_instr != NULL) reservation_stations->entries[i].entry_instr = instr_memory + (reservation_stations->entries[i].entry_instr - other.instr_memory);
+		for (unsigned u=0; u<MAX_UNITS; u++){
+			if (exec_units[u].unit_instr != NULL) exec_units[u].unit_instr = instr_memory + (exec_units[u].unit_instr - other.instr_memory);
+			if (dummy_units[u].unit_instr != NULL) dummy_units[u].unit_instr = instr_memory + (dummy_units[u].unit_instr - other.instr_memory);
+		}
+	} else {
+		instr_memory = other.instr_memory;
+	}
+
+	//memory
+	data_memory_size = other.data_memory_size;
+	data_memory.copy(other.data_memory);
+
+	//execution statistics and log
+	instructions_executed = other.instructions_executed;
+	clock_cycles = other.clock_cycles;
+	counters = other.counters;
+	memcpy(cycle_events, other.cycle_events, sizeof cycle_events);
+	cycle_event_mask = other.cycle_event_mask;
+	cycle_commit = other.cycle_commit;
+	cycle_stall = other.cycle_stall;
+	cycle_stall_age = other.cycle_stall_age;
+	cycle_issue_stall = other.cycle_issue_stall;
+	flushing = other.flushing;
+	log << other.log.str();
+	output = other.output;
+}
+
+sim_ooo *sim_ooo::clone(){
+	return new sim_ooo(*this);
+}
+
+void sim_ooo::save_checkpoint(const char *filename, bool full){
+	Checkpoint_Stream stream(filename, true);
+	checkpoint(stream, full);
+	stream.close();
+}
+
+void sim_ooo::load_checkpoint(const char *filename){
+	Checkpoint_Stream stream(filename, false);
+	checkpoint(stream, false);
+}
+
+void sim_ooo::checkpoint(Checkpoint_Stream &stream, bool full){
+	//when loading, the kind of checkpoint is the one saved
+	unsigned flags = full ? CHECKPOINT_FULL : 0;
+	stream.io(flags);
+	full = flags & CHECKPOINT_FULL;
+	if (trace != NULL){
+		cout << "ERROR:: a simulator reading a functional trace cannot be checkpointed!\n";
+		exit(-1);
+	}
+	if (full && log_writer != NULL){
+		cout << "ERROR:: a simulator writing a binary log cannot be fully checkpointed!\n";
+		exit(-1);
+	}
+	if (!full && !rob->isEmpty()){
+		cout << "ERROR:: the pipeline must be drained before an architectural checkpoint!\n";
+		exit(-1);
+	}
+
+	//program (the restored one becomes the private program image)
+	unsigned base_address = instr_base_address;
+	unsigned num_instructions = instr_memory_size;
+	stream.io(base_address);
+	stream.io(num_instructions);
+	if (stream.saving){
+		for (unsigned i=0; i<num_instructions; i++){
+			instruction_t instr = instr_memory[i];
+			checkpoint_instruction(stream, instr);
+		}
+	} else {
+		clear_program_image(&program);
+		program.instructions.resize(num_instructions);
+		for (unsigned i=0; i<num_instructions; i++) checkpoint_instruction(stream, program.instructions[i]);
+		program.base_address = base_address;
+		load_program(program);
+	}
+	stream.instr_memory = instr_memory;
+	stream.instr_memory_size = instr_memory_size;
+
+	//architectural state
+	stream.io_array(int_reg_file, NUM_GP_REGISTERS);
+	stream.io_array(fp_reg_file, NUM_GP_REGISTERS);
+	stream.io(PC);
+	unsigned memory_size = data_memory_size;
+	stream.io(memory_size);
+	if (memory_size != data_memory_size){
+		data_memory_size = memory_size;
+		data_memory.init(data_memory_size);
+	}
+
+	//microarchitectural state
+	if (full){
+		stream.check(issue_width, "issue width");
+		stream.check(pending_instructions.num_entries, "instruction window size");
+		for (unsigned i=0; i<pending_instructions.num_entries; i++) checkpoint_window_entry(stream, pending_instructions.entries[i]);
+		rob->checkpoint(stream);
+		reservation_stations->checkpoint(stream);
+		lsq->checkpoint(stream);
+		stream.check(num_units, "number of execution units");
+		stream.check(num_dummy_units, "number of address computation units");
+		for (unsigned u=0; u<num_units; u++) checkpoint_unit(stream, exec_units[u]);
+		for (unsigned u=0; u<num_dummy_units; u++) checkpoint_unit(stream, dummy_units[u]);
+		stream.io(curr_dummy_unit);
+		stream.io_array(free_units, NUM_UNIT_TYPES);
+		stream.io(release_count);
+		stream.io_array(release_queue, release_count);
+		wheel.checkpoint(stream);
+		stream.io(current_cycle);
+		stream.io(clock_cycles);
+		stream.io(instructions_executed);
+		stream.io(counters);
+		stream.io(flushing);
+
+		//the log continues from the last instruction logged
+		string text = log.str();
+		stream.io_string(text);
+		if (!stream.saving){
+			log.str("");
+			log << text;
+		}
+	}
+
+	//data memory: the pages written, each at a page boundary of the file
+	vector<unsigned> pages = data_memory.touched;
+	sort(pages.begin(), pages.end());
+	unsigned num_stored = pages.size();
+	stream.io(num_stored);
+	if (num_stored > data_memory.num_pages){
+		cout << "ERROR:: checkpoint with more memory pages than the data memory!\n";
+		exit(-1);
+	}
+	pages.resize(num_stored);
+	stream.io_array(pages.data(), num_stored);
+	if (!stream.saving) data_memory.clear();
+	for (unsigned i=0; i<num_stored; i++){
+		if (pages[i] >= data_memory.num_pages){
+			cout << "ERROR:: checkpoint memory page " << pages[i] << " out of the data memory!\n";
+			exit(-1);
+		}
+		stream.align(CHECKPOINT_PAGE_SIZE);
+		if (stream.saving) stream.io_bytes(const_cast<unsigned char *>(data_memory.read_page(pages[i])), CHECKPOINT_PAGE_SIZE);
+		else stream.io_bytes(data_memory.write_page(pages[i]), CHECKPOINT_PAGE_SIZE);
+	}
+}
+
 sim_ooo::~sim_ooo(){
-	delete [] data_memory;
 	//delete [] rob->entries;
     delete rob;
 	delete [] pending_instructions.entries;
 	delete reservation_stations;
+	delete lsq;
+	delete [] release_queue;
+	delete [] trace_records;
+	delete log_writer;
+	delete pipeview;
+	delete profile;
+	//the host profile of all the runs (see host_profile.h)
+	if (host_profile != NULL) host_profile->print(cerr);
+	delete host_profile;
+	delete interpreter;
 }
 
 /* =============================================================
@@ -685,22 +1572,150 @@ sim_ooo::~sim_ooo(){
    ============================================================= */
 
 /* core of the simulator */
-void sim_ooo::run(unsigned cycles){
-    unsigned j=0u;
+void sim_ooo::run(unsigned long long cycles){
+    unsigned long long j=0u;
+#ifdef HOST_PROFILE
+    if(host_profile == NULL)
+    {
+        host_profile = new Host_Profile(HOST_PROFILE > 1);
+    }
+    host_profile->start(current_cycle, instructions_executed);
+#endif
     while(((j<cycles) || ((cycles == 0u))) )//&& (isValidPC(PC)))// &&  && (instr_memory[PC].opcode != EOP)) && (!rob->isEmpty()))){
     {
-        if((instr_memory[(PC-instr_base_address)/4].opcode == EOP) && (rob->isEmpty()))
+        if(((!isValidPC(PC)) || (instr_memory[(PC-instr_base_address)/4].opcode == EOP) || draining) && (rob->isEmpty()))
         {
-            this->clock_cycles = currClkCycle;
+            this->clock_cycles = current_cycle;
+            if(pipeview != NULL)
+            {
+                pipeview->flush();
+            }
             break;
         }
+        cycle_progress = false;
+        cycle_commit = false;
+        cycle_stall_age = UNDEFINED;
+        cycle_issue_stall = CPI_BASE;
+        for(unsigned mask = cycle_event_mask; mask != 0; mask &= mask - 1)
+        {
+            cycle_events[__builtin_ctz(mask)] = 0;
+        }
+        cycle_event_mask = 0;
         sim_Commit_Handler(this);
         sim_WB_Handler(this);
         sim_Exe_Handler(this);
         sim_Issue_Handler(this);
+        if(redirect_pc != UNDEFINED)
+        {
+            squash();
+        }
+        account_cycles(1);
         j++;
-        currClkCycle++;
+        current_cycle++;
+        if(latency_diverged)
+        {
+            //a unit with a watched latency started in this clock cycle
+            break;
+        }
+        if(instructions_executed >= instruction_limit)
+        {
+            break;
+        }
+        if(event_driven && (!cycle_progress))
+        {
+            //nothing changed in this clock cycle, so nothing changes until the next unit completes:
+            //jump straight to that cycle (without exceeding the requested number of cycles)
+            unsigned long long nextEvent = wheel.next_event(current_cycle);
+            if(nextEvent != UNDEFINED_CYCLE)
+            {
+                unsigned long long skip = nextEvent - current_cycle;
+                if((cycles != 0u) && (skip > (cycles - j)))
+                {
+                    skip = cycles - j;
+                }
+                //the skipped cycles stall like the one just simulated
+                account_cycles(skip);
+                j += skip;
+                current_cycle += skip;
+            }
+        }
     }
+#ifdef HOST_PROFILE
+    host_profile->stop(current_cycle, instructions_executed);
+#endif
+}
+
+void sim_ooo::run_instructions(unsigned long long instructions){
+	instruction_limit = instructions_executed + instructions;
+	run();
+	instruction_limit = UNDEFINED_CYCLE;
+}
+
+void sim_ooo::drain(){
+	draining = true;
+	run();
+	draining = false;
+}
+
+unsigned long long sim_ooo::fast_forward(unsigned long long instructions){
+	if (!rob->isEmpty()){
+		cout << "ERROR:: the pipeline must be drained before fast-forwarding!\n";
+		exit(-1);
+	}
+	if (trace != NULL){
+		cout << "ERROR:: a simulator reading a functional trace cannot fast-forward!\n";
+		exit(-1);
+	}
+	//whole basic blocks run on the interpreter, the rest of the last one an instruction at a time
+	if (interpreter == NULL) interpreter = new Interpreter(this);
+	unsigned long long executed = interpreter->run(instructions);
+	return executed + execute_functional(instructions - executed);
+}
+
+unsigned long long sim_ooo::execute_functional(unsigned long long instructions){
+	unsigned long long executed = 0;
+	while ((executed < instructions) && isValidPC(PC)){
+		const instruction_t &instr = instr_memory[(PC - instr_base_address) / 4];
+		if (instr.opcode == EOP) break;
+		reg_file_element_t *regs = (instr.flags & INSTR_FP) ? fp_reg_file : int_reg_file;
+		unsigned next_pc = PC + 4;
+		unsigned address;
+		switch(instr.opcode){
+			case LW:
+			case LWS:
+				//out-of-range loads read UNDEFINED and out-of-range stores are dropped
+				address = int_reg_file[instr.src1].val + instr.immediate;
+				if (data_memory_size >= 4 && address <= data_memory_size - 4) regs[instr.dest].val = data_memory.load_word(address);
+				else regs[instr.dest].val = UNDEFINED;
+				break;
+			case SW:
+			case SWS:
+				address = int_reg_file[instr.src2].val + instr.immediate;
+				if (data_memory_size >= 4 && address <= data_memory_size - 4) data_memory.store_word(address, regs[instr.src1].val);
+				break;
+			case JUMP:
+				next_pc = alu(JUMP, UNDEFINED, UNDEFINED, instr.immediate, PC);
+				break;
+			case BEQZ:
+			case BNEZ:
+			case BLTZ:
+			case BGTZ:
+			case BLEZ:
+			case BGEZ:
+				next_pc = alu(instr.opcode, int_reg_file[instr.src1].val, UNDEFINED, instr.immediate, PC);
+				break;
+			case ADDI:
+			case SUBI:
+				regs[instr.dest].val = alu(instr.opcode, int_reg_file[instr.src1].val, instr.immediate, UNDEFINED, PC);
+				break;
+			default:
+				regs[instr.dest].val = alu(instr.opcode, regs[instr.src1].val, regs[instr.src2].val, UNDEFINED, PC);
+				break;
+		}
+		PC = next_pc;
+		executed++;
+	}
+	return executed;
 }
 
 //reset the state of the simulator - please complete
@@ -710,16 +1725,17 @@ void sim_ooo::reset(){
 	init_log();	
 
 	// data memory
-	for (unsigned i=0; i<data_memory_size; i++) data_memory[i]=0xFF;
+	data_memory.reset();
 	
 	//instr memory
-	for (int i=0; i<PROGRAM_SIZE;i++){
-		instr_memory[i].opcode=(opcode_t)EOP;
-		instr_memory[i].src1=UNDEFINED;
-		instr_memory[i].src2=UNDEFINED;
-		instr_memory[i].dest=UNDEFINED;
-		instr_memory[i].immediate=UNDEFINED;
-	}
+	delete interpreter;
+	interpreter = NULL;
+	clear_program_image(&program);
+	if (profile != NULL) profile->clear();
+	loaded_image = &program;
+	instr_memory = &program.instructions[0];
+	instr_memory_size = program.instructions.size();
+	rob->map_program(instr_memory_size);
 
 	//general purpose registers
 
@@ -729,9 +1745,15 @@ void sim_ooo::reset(){
 
 	//reservation_stations
 
+	//execution units completion events
+	wheel.clear();
+
 	//execution statistics
+	current_cycle = 0;
 	clock_cycles = 0;
 	instructions_executed = 0;
+	memset(&counters, 0, sizeof counters);
+	flushing = false;
 
 	//other required initializations
 }
@@ -746,75 +1768,267 @@ void sim_ooo::set_int_register(unsigned reg, int value){
     int_reg_file[reg].val = value;
 }
 
-float sim_ooo::get_fp_register(unsigned reg){
-    return unsigned2float(fp_reg_file[reg].val);
+float sim_ooo::get_fp_register(unsigned reg){
+    return bits2float(fp_reg_file[reg].val);
+}
+
+void sim_ooo::set_fp_register(unsigned reg, float value){
+    fp_reg_file[reg].val = float2bits(value);
+}
+
+unsigned sim_ooo::get_int_register_tag(unsigned reg){
+	return int_reg_file[reg].tag;
+}
+
+unsigned sim_ooo::get_fp_register_tag(unsigned reg){
+	return fp_reg_file[reg].tag; //please modify
+}
+
+void sim_ooo::CDB_write(unsigned int tag, unsigned int val) {
+    cycle_progress = true;
+    if(tag < rob->num_entries)
+    {
+        rob->update_dest_val(tag,val);
+        reservation_stations->updateTagVal(tag,val);
+    }else
+    {
+        //std::cout << "\n//TODO: error handling in valid tag on CDB bus";
+    }
+}
+
+/*Functions of the load/store queue*/
+Load_Store_Queue::Load_Store_Queue(unsigned mEntries, sim_ooo *mSim) {
+    sim = mSim;
+    num_entries = mEntries;
+    num_buckets = 1;
+    while(num_buckets < num_entries)
+    {
+        num_buckets <<= 1;
+    }
+    buckets = new unsigned[2*num_buckets];
+    address = new unsigned[num_entries];
+    bucket_of = new unsigned[num_entries];
+    next = new unsigned[num_entries];
+    prev = new unsigned[num_entries];
+    unresolved_stores.init(num_entries);
+    forwarding_stores.init(num_entries);
+    for(unsigned i=0; i<2*num_buckets; i++)
+    {
+        buckets[i] = UNDEFINED;
+    }
+    for(unsigned i=0; i<num_entries; i++)
+    {
+        address[i] = UNDEFINED;
+        bucket_of[i] = UNDEFINED;
+        next[i] = UNDEFINED;
+        prev[i] = UNDEFINED;
+    }
+}
+
+Load_Store_Queue::Load_Store_Queue(const Load_Store_Queue &other, sim_ooo *mSim) {
+    sim = mSim;
+    num_entries = other.num_entries;
+    num_buckets = other.num_buckets;
+    buckets = copy_array(other.buckets, 2*num_buckets);
+    address = copy_array(other.address, num_entries);
+    bucket_of = copy_array(other.bucket_of, num_entries);
+    next = copy_array(other.next, num_entries);
+    prev = copy_array(other.prev, num_entries);
+    unresolved_stores.copy(other.unresolved_stores);
+    forwarding_stores.copy(other.forwarding_stores);
+}
+
+void Load_Store_Queue::checkpoint(Checkpoint_Stream &stream) {
+    stream.check(num_entries, "load/store queue size");
+    stream.io_array(buckets, 2*num_buckets);
+    stream.io_array(address, num_entries);
+    stream.io_array(bucket_of, num_entries);
+    stream.io_array(next, num_entries);
+    stream.io_array(prev, num_entries);
+    unresolved_stores.checkpoint(stream);
+    forwarding_stores.checkpoint(stream);
+}
+
+Load_Store_Queue::~Load_Store_Queue() {
+    delete [] buckets;
+    delete [] address;
+    delete [] bucket_of;
+    delete [] next;
+    delete [] prev;
+}
+
+void Load_Store_Queue::insert(unsigned mBucket, unsigned mROBIndex, unsigned mAddr) {
+    unlink(mROBIndex);
+    address[mROBIndex] = mAddr;
+    bucket_of[mROBIndex] = mBucket;
+    prev[mROBIndex] = UNDEFINED;
+    next[mROBIndex] = buckets[mBucket];
+    if(buckets[mBucket] != UNDEFINED)
+    {
+        prev[buckets[mBucket]] = mROBIndex;
+    }
+    buckets[mBucket] = mROBIndex;
+}
+
+//load whose address is resolved and is waiting for its data
+void Load_Store_Queue::insert_load(unsigned mROBIndex, unsigned mAddr) {
+    insert(load_bucket(mAddr), mROBIndex, mAddr);
+}
+
+//store whose address is resolved (it becomes visible to the loads once the base register write is)
+void Load_Store_Queue::insert_store(unsigned mROBIndex, unsigned mAddr) {
+    insert(num_buckets + load_bucket(mAddr), mROBIndex, mAddr);
+}
+
+//bucket of the loads of the given address; words are spread over consecutive buckets
+unsigned Load_Store_Queue::load_bucket(unsigned mAddr) {
+    return (mAddr >> 2) & (num_buckets - 1);
 }
 
-void sim_ooo::set_fp_register(unsigned reg, float value){
-    fp_reg_file[reg].val = float2unsigned(value);
+void Load_Store_Queue::remove(unsigned mROBIndex) {
+    unresolved_stores.clear(mROBIndex);
+    unlink(mROBIndex);
 }
 
-unsigned sim_ooo::get_int_register_tag(unsigned reg){
-	return int_reg_file[reg].tag;
+void Load_Store_Queue::unlink(unsigned mROBIndex) {
+    if(bucket_of[mROBIndex] == UNDEFINED)
+    {
+        return;
+    }
+    if(prev[mROBIndex] != UNDEFINED)
+    {
+        next[prev[mROBIndex]] = next[mROBIndex];
+    }else
+    {
+        buckets[bucket_of[mROBIndex]] = next[mROBIndex];
+    }
+    if(next[mROBIndex] != UNDEFINED)
+    {
+        prev[next[mROBIndex]] = prev[mROBIndex];
+    }
+    bucket_of[mROBIndex] = UNDEFINED;
+    address[mROBIndex] = UNDEFINED;
 }
 
-unsigned sim_ooo::get_fp_register_tag(unsigned reg){
-	return fp_reg_file[reg].tag; //please modify
+//position of the slot in the ROB, 0 being the head
+unsigned Load_Store_Queue::age(unsigned mROBIndex) {
+    return (mROBIndex + num_entries - sim->rob->get_head_index()) % num_entries;
 }
 
-void sim_ooo::CDB_write(unsigned int tag, unsigned int val) {
-    if(tag < rob->num_entries)
+//a store older than the load that may write its address (UNDEFINED if the load can access memory)
+unsigned Load_Store_Queue::search_prev_store(unsigned mROBIndex, unsigned mAddr) {
+    unsigned mLoadAge = age(mROBIndex);
+    for(unsigned w=0; w<unresolved_stores.num_words; w++)
     {
-        rob->update_dest_val(tag,val);
-        reservation_stations->updateTagVal(tag,val);
-    }else
+        for(unsigned long long mBits = unresolved_stores.words[w]; mBits != 0; mBits &= (mBits - 1))
+        {
+            unsigned i = w*64 + __builtin_ctzll(mBits);
+            unsigned mStation = sim->rob->entries[i].station;
+            if((sim->reservation_stations->tag2[mStation] == UNDEFINED) &&
+               (sim->reservation_stations->entries[mStation].CDBWriteDataAvailClkCyclevalue2 < (long long)sim->current_cycle))
+            {
+                //address visible from now on, the store is found through its bucket
+                unresolved_stores.clear(i);
+            }else if(age(i) < mLoadAge)
+            {
+                return i;
+            }
+        }
+    }
+    for(unsigned i = buckets[num_buckets + load_bucket(mAddr)]; i != UNDEFINED; i = next[i])
     {
-        //std::cout << "\n//TODO: error handling in valid tag on CDB bus";
+        if((address[i] == mAddr) && (age(i) < mLoadAge))
+        {
+            return i;
+        }
+    }
+    return UNDEFINED;
+}
+
+//the loads and stores leave their buckets with their stations, only the store sets are left
+void Load_Store_Queue::flush() {
+    for(unsigned w=0; w<forwarding_stores.num_words; w++)
+    {
+        unresolved_stores.words[w] = 0;
+        forwarding_stores.words[w] = 0;
     }
 }
 
 /*Functions of ROB*/
-ROB::ROB(unsigned int mEntries) {
+ROB::ROB(unsigned int mEntries, sim_ooo *mSim) {
+    sim = mSim;
     num_entries = mEntries;
+    slot_of_pc = NULL;
+    num_pcs = 0;
     if(num_entries > 0) {
-        mROBTotalEntries = num_entries;
         entries = new rob_entry_t[num_entries];
 
         for(int i=0;i<num_entries;i++) {
             clean_rob(&entries[i]);
+            entries[i].entry_instr = NULL;
             entries[i].isAvailable = true;
         }
         headIndex = 0;
         tailIndex = 0;
         currLength = 0;
     }else{
+        entries = NULL;
         //std::cout << "\n//TODO:error handling invalid num entries init failure";
     }
 }
 
+ROB::ROB(const ROB &other, sim_ooo *mSim) {
+    sim = mSim;
+    num_entries = other.num_entries;
+    currLength = other.currLength;
+    headIndex = other.headIndex;
+    tailIndex = other.tailIndex;
+    entries = copy_array(other.entries, num_entries);
+    num_pcs = other.num_pcs;
+    slot_of_pc = copy_array(other.slot_of_pc, num_pcs);
+}
+
+void ROB::checkpoint(Checkpoint_Stream &stream) {
+    stream.check(num_entries, "ROB size");
+    stream.io(currLength);
+    stream.io(headIndex);
+    stream.io(tailIndex);
+    for(unsigned i=0; i<num_entries; i++)
+    {
+        checkpoint_rob_entry(stream, entries[i]);
+    }
+    stream.check(num_pcs, "program size");
+    stream.io_array(slot_of_pc, num_pcs);
+}
+
 ROB::~ROB(){
     delete [] entries;
+    delete [] slot_of_pc;
 }
 
 bool ROB::push(unsigned mPC) {
     bool mRetVal = false;
-    if((currLength < num_entries) && (isValidPC(mPC)) && (entries[tailIndex].pc == UNDEFINED) && (entries[tailIndex].isAvailable == true))
+    if((currLength < num_entries) && (sim->isValidPC(mPC)) && (entries[tailIndex].pc == UNDEFINED) && (entries[tailIndex].isAvailable == true))
     {
         entries[tailIndex].isAvailable = false;
-        entries[tailIndex].entry_instr = mInstrMemPtr[(mPC - mBaseAddr)/4];
+        entries[tailIndex].entry_instr = &sim->instr_memory[(mPC - sim->instr_base_address)/4];
         entries[tailIndex].pc = mPC;
         entries[tailIndex].ready = false;
-        entries[tailIndex].destination = entries[tailIndex].entry_instr.dest;
+        entries[tailIndex].destination = entries[tailIndex].entry_instr->dest;
         entries[tailIndex].isAddressComputed = false;
-
-        currSim->pending_instructions.entries[tailIndex].pc = mPC;
-        currSim->pending_instructions.entries[tailIndex].issue = UNDEFINED;
-        currSim->pending_instructions.entries[tailIndex].exe = UNDEFINED;
-        currSim->pending_instructions.entries[tailIndex].wr = UNDEFINED;
-        currSim->pending_instructions.entries[tailIndex].commit = UNDEFINED;
+        entries[tailIndex].station = UNDEFINED;
+        entries[tailIndex].exe_unit = UNDEFINED;
+        slot_of_pc[(mPC - sim->instr_base_address)/4] = tailIndex;
+
+        sim->pending_instructions.entries[tailIndex].pc = mPC;
+        sim->pending_instructions.entries[tailIndex].issue = UNDEFINED_CYCLE;
+        sim->pending_instructions.entries[tailIndex].exe = UNDEFINED_CYCLE;
+        sim->pending_instructions.entries[tailIndex].wr = UNDEFINED_CYCLE;
+        sim->pending_instructions.entries[tailIndex].commit = UNDEFINED_CYCLE;
         entries[tailIndex].state = ISSUE;
         tailIndex = (tailIndex + 1)%num_entries;  //circular buffer
         currLength++;
+        sim->cycle_progress = true;
         mRetVal = true;
     }else
     {
@@ -837,14 +2051,30 @@ bool ROB::pop() {
     if(currLength > 0)
     {
         clean_rob(&entries[headIndex]);
-        clean_instr_window(&currSim->pending_instructions.entries[headIndex]);
+        clean_instr_window(&sim->pending_instructions.entries[headIndex]);
+        sim->defer_release(RELEASE_ROB, headIndex);
         headIndex = (headIndex + 1)%num_entries;
         currLength--;
+        sim->cycle_progress = true;
         mRetVal = true;
     }
     return mRetVal;
 }
 
+//drops all the entries at once; the ROB restarts from its first entry
+void ROB::flush() {
+    unsigned n=0;
+    for(unsigned i=headIndex; n<currLength; i=(i+1)%num_entries,n++)
+    {
+        clean_rob(&entries[i]);
+        clean_instr_window(&sim->pending_instructions.entries[i]);
+        entries[i].isAvailable = true;
+    }
+    headIndex = 0;
+    tailIndex = 0;
+    currLength = 0;
+}
+
 bool ROB::isFull(){
     return (currLength >= num_entries);
 }
@@ -866,20 +2096,30 @@ bool ROB::update_dest_val(unsigned int entry, unsigned int val) {
     return mRetVal;
 }
 
+//a PC is in the ROB at most once (taken branches flush the ROB), so the side table gives its entry directly
 unsigned int ROB::get_entry_num(unsigned int mPC) {
     unsigned mRetVal = UNDEFINED;
 
-    if(isValidPC(mPC)) {
-        for (int i = 0; i < num_entries; i++) {
-            if (entries[i].pc == mPC) {
-                mRetVal = i;
-                break;
-            }
+    if(sim->isValidPC(mPC)) {
+        unsigned i = slot_of_pc[(mPC - sim->instr_base_address)/4];
+        //the slot is stale if the entry has been popped since
+        if ((i != UNDEFINED) && (entries[i].pc == mPC)) {
+            mRetVal = i;
         }
     }
     return mRetVal;
 }
 
+//sizes the slot lookup for a program of "mInstructions" instructions (called when a program is loaded)
+void ROB::map_program(unsigned mInstructions) {
+    delete [] slot_of_pc;
+    num_pcs = mInstructions;
+    slot_of_pc = new unsigned[num_pcs];
+    for(unsigned i=0;i<num_pcs;i++) {
+        slot_of_pc[i] = UNDEFINED;
+    }
+}
+
 unsigned int ROB::get_head_index() {
     return headIndex;
 }
@@ -891,96 +2131,221 @@ unsigned int ROB::get_tail_index() {
 /*Functions of Reservation Station*/
 
 Reservation_Stations::Reservation_Stations(unsigned  mNum_int_res_stations, unsigned mNum_load_res_stations,
-                                           unsigned mNum_add_res_stations, unsigned mNum_mul_res_stations) {
+                                           unsigned mNum_add_res_stations, unsigned mNum_mul_res_stations, sim_ooo *mSim) {
     unsigned n=0;
+    sim = mSim;
     num_int_stations = mNum_int_res_stations;
     num_load_stations = mNum_load_res_stations;
     num_add_stations = mNum_add_res_stations;
     num_mul_stations = mNum_mul_res_stations;
     num_entries = (num_int_stations+num_load_stations+num_add_stations+num_mul_stations);
-   entries = new res_station_entry_t[num_entries];
+    entries = new res_station_entry_t[num_entries];
+    for (unsigned i=0; i<MAX_RS; i++){
+        free_stations[i].init(num_entries);
+    }
+    occupied.init(num_entries);
+
+    //the padding entries never match a tag and are never ready
+    unsigned num_padded = occupied.num_words * 64;
+    type = new res_station_t[num_padded];
+    value1 = new unsigned[num_padded];
+    value2 = new unsigned[num_padded];
+    tag1 = new unsigned[num_padded];
+    tag2 = new unsigned[num_padded];
+    CDBWriteDataAvailClkCycle = new long long[num_padded];
+    ready = new unsigned long long[occupied.num_words];
+    for (unsigned i=0; i<num_padded; i++){
+        type[i] = MAX_RS;
+        value1[i] = UNDEFINED;
+        value2[i] = UNDEFINED;
+        tag1[i] = UNDEFINED;
+        tag2[i] = UNDEFINED;
+        CDBWriteDataAvailClkCycle[i] = -1;
+    }
 
     for (unsigned i=0; i<num_int_stations; i++,n++){
         entries[n].pc=UNDEFINED;
-        entries[n].type=INTEGER_RS;
+        entries[n].entry_instr=NULL;
+        type[n]=INTEGER_RS;
         entries[n].name=i;
         entries[n].isAvailable = true;
+        free_stations[INTEGER_RS].set(n);
     }
     for (unsigned i=0; i<num_load_stations; i++,n++){
         entries[n].pc=UNDEFINED;
-        entries[n].type=LOAD_B;
+        entries[n].entry_instr=NULL;
+        type[n]=LOAD_B;
         entries[n].name=i;
         entries[n].isAvailable = true;
+        free_stations[LOAD_B].set(n);
     }
     for (unsigned i=0; i<num_add_stations; i++,n++){
         entries[n].pc=UNDEFINED;
-        entries[n].type=ADD_RS;
+        entries[n].entry_instr=NULL;
+        type[n]=ADD_RS;
         entries[n].name=i;
         entries[n].isAvailable = true;
+        free_stations[ADD_RS].set(n);
     }
     for (unsigned i=0; i<num_mul_stations; i++,n++){
         entries[n].pc=UNDEFINED;
-        entries[n].type=MULT_RS;
+        entries[n].entry_instr=NULL;
+        type[n]=MULT_RS;
         entries[n].name=i;
         entries[n].isAvailable = true;
+        free_stations[MULT_RS].set(n);
+    }
+}
+
+Reservation_Stations::Reservation_Stations(const Reservation_Stations &other, sim_ooo *mSim) {
+    sim = mSim;
+    num_int_stations = other.num_int_stations;
+    num_load_stations = other.num_load_stations;
+    num_add_stations = other.num_add_stations;
+    num_mul_stations = other.num_mul_stations;
+    num_entries = other.num_entries;
+    entries = copy_array(other.entries, num_entries);
+    for (unsigned i=0; i<MAX_RS; i++){
+        free_stations[i].copy(other.free_stations[i]);
     }
+    occupied.copy(other.occupied);
+    unsigned num_padded = occupied.num_words * 64;
+    type = copy_array(other.type, num_padded);
+    value1 = copy_array(other.value1, num_padded);
+    value2 = copy_array(other.value2, num_padded);
+    tag1 = copy_array(other.tag1, num_padded);
+    tag2 = copy_array(other.tag2, num_padded);
+    CDBWriteDataAvailClkCycle = copy_array(other.CDBWriteDataAvailClkCycle, num_padded);
+    ready = copy_array(other.ready, occupied.num_words);
+}
+
+void Reservation_Stations::checkpoint(Checkpoint_Stream &stream) {
+    stream.check(num_int_stations, "number of integer reservation stations");
+    stream.check(num_load_stations, "number of load buffers");
+    stream.check(num_add_stations, "number of ADD reservation stations");
+    stream.check(num_mul_stations, "number of MULT/DIV reservation stations");
+    for (unsigned i=0; i<num_entries; i++){
+        checkpoint_station(stream, entries[i]);
+    }
+    for (unsigned i=0; i<MAX_RS; i++){
+        free_stations[i].checkpoint(stream);
+    }
+    occupied.checkpoint(stream);
+    unsigned num_padded = occupied.num_words * 64;
+    stream.io_array(type, num_padded);
+    stream.io_array(value1, num_padded);
+    stream.io_array(value2, num_padded);
+    stream.io_array(tag1, num_padded);
+    stream.io_array(tag2, num_padded);
+    stream.io_array(CDBWriteDataAvailClkCycle, num_padded);
 }
 
 Reservation_Stations::~Reservation_Stations() {
     delete [] entries;
+    delete [] type;
+    delete [] value1;
+    delete [] value2;
+    delete [] tag1;
+    delete [] tag2;
+    delete [] CDBWriteDataAvailClkCycle;
+    delete [] ready;
 }
 
-bool Reservation_Stations::isReservationStationAvailable(opcode_t opcode)
+bool Reservation_Stations::isReservationStationAvailable(const instruction_t *instr)
 {
     bool mRetVal=false;
     res_station_t requiredStationType;
-    requiredStationType = get_unit_type(opcode);
-    for(int i=0;i<num_entries;i++)
+    requiredStationType = (res_station_t)instr->station;
+    if(requiredStationType != MAX_RS)
     {
-        if(entries[i].type == requiredStationType)
-        {
-            if((entries[i].pc == UNDEFINED) && (entries[i].isAvailable == true))
-            {
-                mRetVal = true;
-                break;
-            }
-        }
+        mRetVal = !free_stations[requiredStationType].isEmpty();
     }
     return mRetVal;
 }
 
-res_station_entry_t * Reservation_Stations::fetchReservationStation(opcode_t opcode)
+res_station_entry_t * Reservation_Stations::fetchReservationStation(const instruction_t *instr)
 {
     res_station_entry_t * mRetVal= NULL;
     res_station_t requiredStationType;
-    requiredStationType = get_unit_type(opcode);
-    for(int i=0;i<num_entries;i++)
+    requiredStationType = (res_station_t)instr->station;
+    if(requiredStationType != MAX_RS)
     {
-        if(entries[i].type == requiredStationType)
+        unsigned i = free_stations[requiredStationType].first();
+        if(i != UNDEFINED)
         {
-            if((entries[i].pc == UNDEFINED) && (entries[i].isAvailable == true))
-            {
-                mRetVal = &entries[i];
-                break;
-            }
+            mRetVal = &entries[i];
         }
     }
     return mRetVal;
 }
+
+//clears a station; it can be allocated again from the next clock cycle
+void Reservation_Stations::release_station(unsigned i)
+{
+    if(entries[i].pc != UNDEFINED)
+    {
+        sim->defer_release(RELEASE_STATION, i);
+    }
+    clean(i);
+}
+
+/* clears a reservation station */
+void Reservation_Stations::clean(unsigned i)
+{
+    if((entries[i].pc != UNDEFINED) && (entries[i].entry_instr->flags & INSTR_MEMORY))
+    {
+        sim->lsq->remove(entries[i].destination);
+    }
+    entries[i].pc=UNDEFINED;
+    entries[i].destination=UNDEFINED;
+    entries[i].address=UNDEFINED;
+    entries[i].CDBWriteDataAvailClkCyclevalue2 = -1;
+    value1[i]=UNDEFINED;
+    value2[i]=UNDEFINED;
+    tag1[i]=UNDEFINED;
+    tag2[i]=UNDEFINED;
+    CDBWriteDataAvailClkCycle[i]= -1;
+    occupied.clear(i);
+}
+
+void Reservation_Stations::free_station(unsigned i)
+{
+    entries[i].isAvailable = true;
+    free_stations[type[i]].set(i);
+}
+
+//clears all the stations and makes them available immediately (the stations released
+//in the current cycle must have been freed already)
+void Reservation_Stations::flush()
+{
+    for(unsigned w=0; w<occupied.num_words; w++)
+    {
+        for(unsigned long long mBits = occupied.words[w]; mBits != 0; mBits &= (mBits - 1))
+        {
+            unsigned i = w*64 + __builtin_ctzll(mBits);
+            clean(i);
+            free_station(i);
+        }
+    }
+}
 //Note: Insert row in reservation station after pushing the instruction to ROB
 bool Reservation_Stations::insertEntry(unsigned mPC) {
     bool mRetVal = true;
-    if(isValidPC(mPC))
+    if(sim->isValidPC(mPC))
     {
-        instruction_t tempInstr = mInstrMemPtr[(mPC - mBaseAddr) / 4];
+        const instruction_t &tempInstr = sim->instr_memory[(mPC - sim->instr_base_address) / 4];
 
-        res_station_entry_t  * tempStation = fetchReservationStation(tempInstr.opcode);
+        res_station_entry_t  * tempStation = fetchReservationStation(&tempInstr);
         if(tempStation)
         {
+            unsigned n = tempStation - entries;
             tempStation->isAvailable = false;
+            free_stations[type[n]].clear(n);
+            occupied.set(n);
             tempStation->pc = mPC;
-            tempStation->entry_instr = tempInstr;
-            tempStation->destination = currSim->rob->get_entry_num(mPC);
+            tempStation->entry_instr = &tempInstr;
+            tempStation->destination = sim->rob->get_entry_num(mPC);
+            sim->rob->entries[tempStation->destination].station = n;
             if((tempInstr.opcode == SW) || (tempInstr.opcode == SWS))
             {
                 /*SWS F1     4   (R1)           SW  R5     4   (R1)
@@ -994,20 +2359,20 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 {
                     tempIndex = tempInstr.src1;
                     if (tempIndex < NUM_GP_REGISTERS) {
-                        if (currSim->int_reg_file[tempIndex].tag == UNDEFINED) {
+                        if (sim->int_reg_file[tempIndex].tag == UNDEFINED) {
                             /*The register is available in REG file, fetch the val and store*/
-                            tempStation->value1 = currSim->int_reg_file[tempIndex].val;
-                            tempStation->tag1 = UNDEFINED;
+                            value1[n] = sim->int_reg_file[tempIndex].val;
+                            tag1[n] = UNDEFINED;
                         } else {
-                            if (currSim->int_reg_file[tempIndex].tag < currSim->rob->num_entries) {
-                                if (currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].ready) {
+                            if (sim->int_reg_file[tempIndex].tag < sim->rob->num_entries) {
+                                if (sim->rob->entries[sim->int_reg_file[tempIndex].tag].ready) {
                                     /*The register is available in ROB, fetch the val and store*/
-                                    tempStation->value1 = currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].value;
-                                    tempStation->tag1 = UNDEFINED;
+                                    value1[n] = sim->rob->entries[sim->int_reg_file[tempIndex].tag].value;
+                                    tag1[n] = UNDEFINED;
                                 } else {
                                     /*The register is NOT available mark tag*/
-                                    tempStation->value1 = UNDEFINED;
-                                    tempStation->tag1 = currSim->int_reg_file[tempIndex].tag;
+                                    value1[n] = UNDEFINED;
+                                    tag1[n] = sim->int_reg_file[tempIndex].tag;
                                 }
                             } else {
                                 //std::cout << "\n//TODO: error handling invalid tag";
@@ -1022,20 +2387,20 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 {
                     tempIndex = tempInstr.src1;
                     if (tempIndex < NUM_GP_REGISTERS) {
-                        if (currSim->fp_reg_file[tempIndex].tag == UNDEFINED) {
+                        if (sim->fp_reg_file[tempIndex].tag == UNDEFINED) {
                             /*The register is available in REG file, fetch the val and store*/
-                            tempStation->value1 = currSim->fp_reg_file[tempIndex].val;
-                            tempStation->tag1 = UNDEFINED;
+                            value1[n] = sim->fp_reg_file[tempIndex].val;
+                            tag1[n] = UNDEFINED;
                         } else {
-                            if (currSim->fp_reg_file[tempIndex].tag < currSim->rob->num_entries) {
-                                if (currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].ready) {
+                            if (sim->fp_reg_file[tempIndex].tag < sim->rob->num_entries) {
+                                if (sim->rob->entries[sim->fp_reg_file[tempIndex].tag].ready) {
                                     /*The register is available in ROB, fetch the val and store*/
-                                    tempStation->value1 = currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].value;
-                                    tempStation->tag1 = UNDEFINED;
+                                    value1[n] = sim->rob->entries[sim->fp_reg_file[tempIndex].tag].value;
+                                    tag1[n] = UNDEFINED;
                                 } else {
                                     /*The register is NOT available mark tag*/
-                                    tempStation->value1 = UNDEFINED;
-                                    tempStation->tag1 = currSim->fp_reg_file[tempIndex].tag;
+                                    value1[n] = UNDEFINED;
+                                    tag1[n] = sim->fp_reg_file[tempIndex].tag;
                                 }
                             } else {
                                 //std::cout << "\n//TODO: error handling invalid tag";
@@ -1051,25 +2416,25 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src2;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->int_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->int_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available, fetch the val and store*/
-                        tempStation->value2 = currSim->int_reg_file[tempIndex].val;
-                        tempStation->tag2 = UNDEFINED;
+                        value2[n] = sim->int_reg_file[tempIndex].val;
+                        tag2[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->int_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->int_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->int_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value2 = currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].value;
-                                tempStation->tag2 = UNDEFINED;
+                                value2[n] = sim->rob->entries[sim->int_reg_file[tempIndex].tag].value;
+                                tag2[n] = UNDEFINED;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value2 = UNDEFINED;
-                                tempStation->tag2 = currSim->int_reg_file[tempIndex].tag;
+                                value2[n] = UNDEFINED;
+                                tag2[n] = sim->int_reg_file[tempIndex].tag;
                             }
                         } else
                         {
@@ -1084,7 +2449,14 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 }
 
                 tempStation->address = tempInstr.immediate;
-
+                //the store address is known as soon as the base register is
+                if(tag2[n] == UNDEFINED)
+                {
+                    sim->lsq->insert_store(tempStation->destination, value2[n] + tempInstr.immediate);
+                }else
+                {
+                    sim->lsq->unresolved_stores.set(tempStation->destination);
+                }
 
             }else if(tempInstr.opcode == JUMP)
             {
@@ -1093,10 +2465,10 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                  *   value1
                  *
                  * */
-                tempStation->value1 = tempInstr.immediate;
-                tempStation->tag1 = UNDEFINED;
-                tempStation->value2 = 0;
-                tempStation->tag2 = UNDEFINED;
+                value1[n] = tempInstr.immediate;
+                tag1[n] = UNDEFINED;
+                value2[n] = 0;
+                tag2[n] = UNDEFINED;
 
             }else if((is_branch(tempInstr.opcode)) || (tempInstr.opcode == LW) ||
                     ((tempInstr.opcode == LWS)) || (is_int_imm(tempInstr.opcode)))
@@ -1110,25 +2482,25 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src1;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->int_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->int_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available in REG file, fetch the val and store*/
-                        tempStation->value1 = currSim->int_reg_file[tempIndex].val;
-                        tempStation->tag1 = UNDEFINED;
+                        value1[n] = sim->int_reg_file[tempIndex].val;
+                        tag1[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->int_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->int_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->int_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value1 = currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].value;
-                                tempStation->tag1 = UNDEFINED;
+                                value1[n] = sim->rob->entries[sim->int_reg_file[tempIndex].tag].value;
+                                tag1[n] = UNDEFINED;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value1 = UNDEFINED;
-                                tempStation->tag1 = currSim->int_reg_file[tempIndex].tag;
+                                value1[n] = UNDEFINED;
+                                tag1[n] = sim->int_reg_file[tempIndex].tag;
                             }
                         } else
                         {
@@ -1143,27 +2515,31 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 }
                 if((tempInstr.opcode == LW) || ((tempInstr.opcode == LWS)))
                 {
-                    tempStation->value2 = UNDEFINED;
+                    value2[n] = UNDEFINED;
                     tempStation->address = tempInstr.immediate;
-                    tempStation->tag2 = UNDEFINED;
+                    tag2[n] = UNDEFINED;
+                    if(tag1[n] == UNDEFINED)
+                    {
+                        sim->lsq->insert_load(tempStation->destination, value1[n] + tempInstr.immediate);
+                    }
                 }else
                 {
-                    tempStation->value2 = tempInstr.immediate;
-                    tempStation->tag2 = UNDEFINED;
+                    value2[n] = tempInstr.immediate;
+                    tag2[n] = UNDEFINED;
                 }
                 if((is_branch(tempInstr.opcode)) || (is_int_imm(tempInstr.opcode)))
                 {
-                    tempStation->value2 = UNDEFINED;
-                    tempStation->tag2 = UNDEFINED;
+                    value2[n] = UNDEFINED;
+                    tag2[n] = UNDEFINED;
                 }
                 if(!(is_branch(tempInstr.opcode))) {
                     //Update destination register tags
                     tempIndex = tempInstr.dest;
                     if (tempIndex < NUM_GP_REGISTERS) {
                         if (((tempInstr.opcode == LW)) || (is_int_imm(tempInstr.opcode))) {
-                            currSim->int_reg_file[tempIndex].tag = currSim->rob->get_entry_num(mPC);
+                            sim->int_reg_file[tempIndex].tag = tempStation->destination;
                         } else if (tempInstr.opcode == LWS) {
-                            currSim->fp_reg_file[tempIndex].tag = currSim->rob->get_entry_num(mPC);
+                            sim->fp_reg_file[tempIndex].tag = tempStation->destination;
                         } else {
                             //std::cout << "\n//TODO: error handling invalid destination opcode";
                             mRetVal = false;
@@ -1185,25 +2561,25 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src1;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->int_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->int_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available, fetch the val and store*/
-                        tempStation->value1 = currSim->int_reg_file[tempIndex].val;
-                        tempStation->tag1 = UNDEFINED;
+                        value1[n] = sim->int_reg_file[tempIndex].val;
+                        tag1[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->int_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->int_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->int_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value1 = currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].value;
-                                tempStation->tag1 = UNDEFINED;
+                                value1[n] = sim->rob->entries[sim->int_reg_file[tempIndex].tag].value;
+                                tag1[n] = UNDEFINED;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value1 = UNDEFINED;
-                                tempStation->tag1 = currSim->int_reg_file[tempIndex].tag;
+                                value1[n] = UNDEFINED;
+                                tag1[n] = sim->int_reg_file[tempIndex].tag;
                             }
                         } else
                         {
@@ -1220,25 +2596,25 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src2;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->int_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->int_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available, fetch the val and store*/
-                        tempStation->value2 = currSim->int_reg_file[tempIndex].val;
-                        tempStation->tag2 = UNDEFINED;
+                        value2[n] = sim->int_reg_file[tempIndex].val;
+                        tag2[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->int_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->int_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->int_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value2 = currSim->rob->entries[currSim->int_reg_file[tempIndex].tag].value;
-                                tempStation->tag2 = UNDEFINED;
+                                value2[n] = sim->rob->entries[sim->int_reg_file[tempIndex].tag].value;
+                                tag2[n] = UNDEFINED;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value2 = UNDEFINED;
-                                tempStation->tag2 = currSim->int_reg_file[tempIndex].tag;
+                                value2[n] = UNDEFINED;
+                                tag2[n] = sim->int_reg_file[tempIndex].tag;
                             }
                         } else
                         {
@@ -1256,7 +2632,7 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.dest;
                 if(tempIndex < NUM_GP_REGISTERS)
                 {
-                    currSim->int_reg_file[tempIndex].tag = currSim->rob->get_entry_num(mPC);
+                    sim->int_reg_file[tempIndex].tag = tempStation->destination;
                 }else
                 {
                     //std::cout << "\n//TODO: error handling invalid destination";
@@ -1274,25 +2650,25 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src1;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->fp_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->fp_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available, fetch the val and store*/
-                        tempStation->value1 = currSim->fp_reg_file[tempIndex].val;
-                        tempStation->tag1 = UNDEFINED;
+                        value1[n] = sim->fp_reg_file[tempIndex].val;
+                        tag1[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->fp_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->fp_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->fp_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value1 = currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].value;
-                                tempStation->tag1 = UNDEFINED;
+                                value1[n] = sim->rob->entries[sim->fp_reg_file[tempIndex].tag].value;
+                                tag1[n] = UNDEFINED;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value1 = UNDEFINED;
-                                tempStation->tag1 = currSim->fp_reg_file[tempIndex].tag;
+                                value1[n] = UNDEFINED;
+                                tag1[n] = sim->fp_reg_file[tempIndex].tag;
                             }
                         } else
                         {
@@ -1309,26 +2685,26 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.src2;
                 if(tempIndex< NUM_GP_REGISTERS)
                 {
-                    if(currSim->fp_reg_file[tempIndex].tag == UNDEFINED)
+                    if(sim->fp_reg_file[tempIndex].tag == UNDEFINED)
                     {
                         /*The register is available, fetch the val and store*/
-                        tempStation->value2 = currSim->fp_reg_file[tempIndex].val;
-                        tempStation->tag2 = UNDEFINED;
+                        value2[n] = sim->fp_reg_file[tempIndex].val;
+                        tag2[n] = UNDEFINED;
                     }else
                     {
-                        if(currSim->fp_reg_file[tempIndex].tag < currSim->rob->num_entries)
+                        if(sim->fp_reg_file[tempIndex].tag < sim->rob->num_entries)
                         {
-                            if(currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].ready)
+                            if(sim->rob->entries[sim->fp_reg_file[tempIndex].tag].ready)
                             {
                                 /*The register is available in ROB, fetch the val and store*/
-                                tempStation->value2 = currSim->rob->entries[currSim->fp_reg_file[tempIndex].tag].value;
-                                tempStation->tag2 = UNDEFINED;
+                                value2[n] = sim->rob->entries[sim->fp_reg_file[tempIndex].tag].value;
+                                tag2[n] = UNDEFINED;
                                 mRetVal = true;
                             }else
                             {
                                 /*The register is NOT available mark tag*/
-                                tempStation->value2 = UNDEFINED;
-                                tempStation->tag2 = currSim->fp_reg_file[tempIndex].tag;
+                                value2[n] = UNDEFINED;
+                                tag2[n] = sim->fp_reg_file[tempIndex].tag;
                                 mRetVal = true;
                             }
                         } else
@@ -1346,7 +2722,7 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
                 tempIndex = tempInstr.dest;
                 if(tempIndex < NUM_GP_REGISTERS)
                 {
-                    currSim->fp_reg_file[tempIndex].tag = currSim->rob->get_entry_num(mPC);
+                    sim->fp_reg_file[tempIndex].tag = tempStation->destination;
                 }else
                 {
                     //std::cout << "\n//TODO: error handling invalid destination";
@@ -1362,7 +2738,7 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
             //undo if could NOT insert
             if(mRetVal == false)
             {
-                tempStation->pc = UNDEFINED;
+                release_station(n);
             }
 
         } else if((tempInstr.opcode == SW) || (tempInstr.opcode == SWS))
@@ -1381,85 +2757,59 @@ bool Reservation_Stations::insertEntry(unsigned mPC) {
     return  mRetVal;
 }
 
+//CDB broadcast: wakes up the stations waiting on the given tag
 void Reservation_Stations::updateTagVal(unsigned int tag, unsigned int val) {
-    for(int i=0;i<num_entries;i++)
+    long long mWrClkCycle = sim->pending_instructions.entries[tag].wr;
+    for(unsigned w=0; w<occupied.num_words; w++)
     {
-        if(entries[i].tag1 == tag)
+        unsigned long long mBits;
+        for(mBits = match_tag(&tag1[w*64], tag); mBits != 0; mBits &= (mBits - 1))
         {
-            entries[i].tag1 = UNDEFINED;
-            entries[i].value1 = val;
-            entries[i].CDBWriteDataAvailClkCycle = currSim->pending_instructions.entries[tag].wr;
+            unsigned i = w*64 + __builtin_ctzll(mBits);
+            tag1[i] = UNDEFINED;
+            value1[i] = val;
+            CDBWriteDataAvailClkCycle[i] = mWrClkCycle;
+            if(entries[i].entry_instr->flags & INSTR_LOAD)
+            {
+                sim->lsq->insert_load(entries[i].destination, val + entries[i].entry_instr->immediate);
+            }
         }
-        if(entries[i].tag2 == tag)
+        for(mBits = match_tag(&tag2[w*64], tag); mBits != 0; mBits &= (mBits - 1))
         {
-            entries[i].tag2 = UNDEFINED;
-            entries[i].value2 = val;
-            entries[i].CDBWriteDataAvailClkCycle = currSim->pending_instructions.entries[tag].wr;
-            if(isStoreInstr(entries[i].entry_instr.opcode))
+            unsigned i = w*64 + __builtin_ctzll(mBits);
+            tag2[i] = UNDEFINED;
+            value2[i] = val;
+            CDBWriteDataAvailClkCycle[i] = mWrClkCycle;
+            if(entries[i].entry_instr->flags & INSTR_STORE)
             {
-                entries[i].CDBWriteDataAvailClkCyclevalue2 = entries[i].CDBWriteDataAvailClkCycle;
+                entries[i].CDBWriteDataAvailClkCyclevalue2 = CDBWriteDataAvailClkCycle[i];
+                sim->lsq->insert_store(entries[i].destination, val + entries[i].entry_instr->immediate);
             }
         }
     }
 }
-res_station_t Reservation_Stations::get_unit_type(opcode_t opcode) {
-
-    res_station_t mRetVal = MAX_RS;
-        switch(opcode){
-            //Integer unit
-            case ADD:
-            case ADDI:
-            case SUB:
-            case SUBI:
-            case XOR:
-            case AND:
-            case BEQZ:
-            case BNEZ:
-            case BLTZ:
-            case BGTZ:
-            case BLEZ:
-            case BGEZ:
-            case JUMP:
-                mRetVal = INTEGER_RS;
-                break;
-                //memory unit
-            case SW:
-            case SWS:
-/*                mRetVal = MAX_RS;
-                //No need reservation stations for Store
-                break;*/
-            case LW:
-            case LWS:
-                mRetVal = LOAD_B;
-                break;
-                // FP adder
-            case ADDS:
-            case SUBS:
-                mRetVal = ADD_RS;
-                break;
-                // Multiplier
-            case MULT:
-            case MULTS:
-            case DIV:
-            case DIVS:
-                mRetVal = MULT_RS;
-                break;
-            default:
-                mRetVal = MAX_RS;
-                //std::cout << "\n//TODO: error handling invalid opcode";
-                break;
-        }
-    return mRetVal;
+
+//bitmask of the occupied stations with both operands available before the given cycle;
+//the returned array has one word per 64 stations and is overwritten by the next call
+unsigned long long * Reservation_Stations::ready_mask(long long mClkCycle) {
+    for(unsigned w=0; w<occupied.num_words; w++)
+    {
+        ready[w] = occupied.words[w] & match_ready(&tag1[w*64], &tag2[w*64], &CDBWriteDataAvailClkCycle[w*64], mClkCycle);
+    }
+    return ready;
 }
 
+//the ROB entry of the instruction records the station it was inserted in
 unsigned int Reservation_Stations::get_station_num(unsigned int mPC) {
     unsigned mRetVal = UNDEFINED;
-    for(int i=0;i<num_entries;i++)
+    unsigned mROBIndex = sim->rob->get_entry_num(mPC);
+    if(mROBIndex != UNDEFINED)
     {
-        if(entries[i].pc == mPC)
+        unsigned i = sim->rob->entries[mROBIndex].station;
+        //the station is released at write result
+        if((i != UNDEFINED) && (entries[i].pc == mPC))
         {
             mRetVal = i;
-            break;
         }
     }
     return mRetVal;
@@ -1506,149 +2856,151 @@ bool isOpcodeFpType(opcode_t mOpCode)
 
 void sim_Issue_Handler(sim_ooo * mSim)
 {
+    HOST_PROFILE_SCOPE(mSim, HOST_ISSUE);
+    //nothing is issued while the pipeline drains
+    if (mSim->draining) return;
     //check if reservation station and ROB are available
-    instruction_t currInstr;
-    if(!isBranchMispredicted) {
-        for (int i = 0; i < mSim->issue_width; i++) {
-            if (isValidPC(mSim->PC)) {
-                currInstr = mSim->instr_memory[(mSim->PC - mBaseAddr) / 4];
-                //check if ROB is available
-                if (currInstr.opcode != EOP) {
-                    if (!mSim->rob->isFull()) {
-                        if (mSim->reservation_stations->isReservationStationAvailable(currInstr.opcode)) {
-                            if (mSim->rob->push(mSim->PC)) {
-                                //ROB push success
-                                if (mSim->reservation_stations->insertEntry(mSim->PC)) {
-                                    //reservation station insert success
-                                    //increment program counter
-                                    update_instr_window(mSim->PC, ISSUE);
-                                    mSim->PC += 4;
-                                } else {
-                                    //std::cout << "\n//TODO: error handling reservation station insert failure";
+    for (int i = 0; i < mSim->issue_width; i++) {
+        if (mSim->isValidPC(mSim->PC)) {
+            const instruction_t &currInstr = mSim->instr_memory[(mSim->PC - mSim->instr_base_address) / 4];
+            //check if ROB is available
+            if (currInstr.opcode != EOP) {
+                if (!mSim->rob->isFull()) {
+                    if (mSim->reservation_stations->isReservationStationAvailable(&currInstr)) {
+                        if (mSim->rob->push(mSim->PC)) {
+                            //ROB push success
+                            if (mSim->reservation_stations->insertEntry(mSim->PC)) {
+                                //reservation station insert success
+                                //increment program counter
+                                update_instr_window(mSim, mSim->PC, ISSUE);
+                                if (mSim->trace != NULL) {
+                                    mSim->read_trace(mSim->PC);
                                 }
+                                mSim->PC += 4;
                             } else {
-                                //std::cout << "\n//TODO: error handling ROB push failure (shouldn't hit this line coz full check done)";
+                                //std::cout << "\n//TODO: error handling reservation station insert failure";
                             }
                         } else {
-                            //reservation station not available
-                            break;
+                            //std::cout << "\n//TODO: error handling ROB push failure (shouldn't hit this line coz full check done)";
                         }
                     } else {
-                        //ROB full
+                        //reservation station not available
+                        mSim->count_stall(STALL_RS_FULL(currInstr.station));
+                        mSim->cycle_issue_stall = CPI_RS_FULL(currInstr.station);
                         break;
                     }
                 } else {
-                    //reached EOP
+                    //ROB full
+                    mSim->count_stall(STALL_ROB_FULL);
+                    mSim->cycle_issue_stall = CPI_ROB_FULL;
                     break;
                 }
             } else {
-                //std::cout << "\n//TODO: error handling invalid PC at issue";
+                //reached EOP
+                break;
             }
+        } else {
+            //std::cout << "\n//TODO: error handling invalid PC at issue";
         }
-    }else
-    {
-        isBranchMispredicted = false;
     }
 }
 void sim_Exe_Handler(sim_ooo * mSim)
 {
-    //check each entry of reservation station. if operands available and required exec unit available then send the instr to its exec unit
-    for(int i=0;i<mSim->reservation_stations->num_entries;i++)
+    HOST_PROFILE_SCOPE(mSim, HOST_EXE);
+    //walk the stations whose operands are available (ascending station order, as the
+    //original full scan did) and send each instruction to its exec unit if one is free
+    unsigned long long * mReady = mSim->reservation_stations->ready_mask(mSim->current_cycle);
+    for(unsigned w=0; w<mSim->reservation_stations->occupied.num_words; w++)
     {
-        res_station_entry_t * currStationEntry;
-        currStationEntry = &mSim->reservation_stations->entries[i];
-
-        //check if the instruction is already being executed
-        if((isValidPC(currStationEntry->pc)) && (search_exe_unit(currStationEntry->pc) == UNDEFINED))
+        unsigned long long mWaiting = mSim->reservation_stations->occupied.words[w] & ~mReady[w];
+        if(mWaiting != 0)
         {
-                //check if the operands are available
-                if ((currStationEntry->tag1 == UNDEFINED) && (currStationEntry->tag2 == UNDEFINED))
-                {
-                    //check if there's a pending store to the same address if the instr is a load
-                    if((!isLoadInstr(currStationEntry->entry_instr.opcode)) ||
-                       ((is_memory(currStationEntry->entry_instr.opcode)) && (search_prev_load_store(currStationEntry) == UNDEFINED))) {
-                        //All the required operands are available send the instruction to corresponding execution unit if available
-
-                        if (currStationEntry->CDBWriteDataAvailClkCycle < (int)currClkCycle)
-                        {
-                            if(((isLoadInstr(currStationEntry->entry_instr.opcode) && (currStationEntry->value2 != UNDEFINED)) || (currStationEntry->entry_instr.opcode == SW) || (currStationEntry->entry_instr.opcode == SWS)) &&
-                               (currSim->rob->entries[currSim->rob->get_entry_num(currStationEntry->pc)].isAddressComputed == false))
-                            {
-                                if((mDummyExeUnit[mCurrDummyUnitIndex].pc == UNDEFINED) && (mDummyExeUnit[mCurrDummyUnitIndex].isAvailable == true))
-                                {
-                                    currSim->rob->entries[currSim->rob->get_entry_num(currStationEntry->pc)].isAddressComputed = true;
-                                    if(isLoadInstr(currStationEntry->entry_instr.opcode))
-                                    {
-                                        mDummyExeUnit[mCurrDummyUnitIndex].pc = currStationEntry->pc;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].unit_instr = currStationEntry->entry_instr;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].isAvailable = false;
-                                        //store bypassing done for this load
-                                        //if(currStationEntry->value2 != UNDEFINED)
-                                        //{
-                                            mDummyExeUnit[mCurrDummyUnitIndex].output = currStationEntry->value2;
-                                            update_instr_window(currStationEntry->pc, EXECUTE);
-                                            currSim->rob->entries[currSim->rob->get_entry_num(currStationEntry->pc)].state = EXECUTE;
-                                        //}
-                                        mDummyExeUnit[mCurrDummyUnitIndex].reservationStationIndex = i;
-                                        currStationEntry->address = currStationEntry->value1 + currStationEntry->address;
-                                    }else
-                                    {
-                                        mDummyExeUnit[mCurrDummyUnitIndex].pc = currStationEntry->pc;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].unit_instr = currStationEntry->entry_instr;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].isAvailable = false;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].output = currStationEntry->value2;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].reservationStationIndex = i;
-                                        currStationEntry->address = currStationEntry->value2 + currStationEntry->address;
-                                        currSim->rob->entries[currSim->rob->get_entry_num(mDummyExeUnit[mCurrDummyUnitIndex].pc)].destination = currSim->reservation_stations->entries[mDummyExeUnit[mCurrDummyUnitIndex].reservationStationIndex].address;
-                                        mDummyExeUnit[mCurrDummyUnitIndex].output = currSim->reservation_stations->entries[mDummyExeUnit[mCurrDummyUnitIndex].reservationStationIndex].value1;
-                                        update_instr_window(currStationEntry->pc, EXECUTE);
-                                        currSim->rob->entries[currSim->rob->get_entry_num(currStationEntry->pc)].state = EXECUTE;
-                                    }
-                                    mCurrDummyUnitIndex = (mCurrDummyUnitIndex + 1)%mNumDummyUnits;
-                                }
-                                continue;
-                            }
-                            unsigned tempUnitIndex = mSim->get_free_unit(currStationEntry->entry_instr.opcode);
-                            if (tempUnitIndex != UNDEFINED)
-                            {
-                                //required unit is available pass the station data to the unit
-                                mSim->exec_units[tempUnitIndex].pc = currStationEntry->pc;
-                                mSim->exec_units[tempUnitIndex].unit_instr = currStationEntry->entry_instr;
-                                mSim->exec_units[tempUnitIndex].busy = mSim->exec_units[tempUnitIndex].latency;
-                                mSim->exec_units[tempUnitIndex].reservationStationIndex = i;
-                                mSim->exec_units[tempUnitIndex].isAvailable = false;
-                                if (isLoadInstr(currStationEntry->entry_instr.opcode))
-                                {
-                                    currStationEntry->address = currStationEntry->value1 + currStationEntry->address;
-                                }
-                                update_instr_window(currStationEntry->pc, EXECUTE);
-                                currSim->rob->entries[currSim->rob->get_entry_num(currStationEntry->pc)].state = EXECUTE;
+            mSim->count_stall(STALL_OPERANDS, __builtin_popcountll(mWaiting));
+        }
+        for(unsigned long long mBits = mReady[w]; mBits != 0; mBits &= (mBits - 1))
+        {
+            unsigned i = w*64 + __builtin_ctzll(mBits);
+            res_station_entry_t * currStationEntry;
+            currStationEntry = &mSim->reservation_stations->entries[i];
 
-                            } else
-                            {
-                                //exec unit not yet available wait and retry next cycle
-                            }
-                        } else
-                        {
-                            //currStationEntry->CDBWriteDataAvailClkCycle = UNDEFINED;
-                        }
+            //check if the instruction is already being executed
+            if(search_exe_unit(mSim, currStationEntry->pc) != UNDEFINED)
+            {
+                continue;
+            }
+            //the station destination is the ROB entry (tag) of the instruction
+            rob_entry_t * currROBEntry = &mSim->rob->entries[currStationEntry->destination];
+            //check if there's a pending store to the same address if the instr is a load
+            if((currStationEntry->entry_instr->flags & INSTR_LOAD) &&
+               (mSim->lsq->search_prev_store(currStationEntry->destination, mSim->reservation_stations->value1[i] + currStationEntry->entry_instr->immediate) != UNDEFINED))
+            {
+                mSim->count_stall(STALL_MEMORY_ORDER);
+                blame_stall(mSim, CPI_MEMORY_ORDER, currStationEntry->destination);
+                continue;
+            }
+            //All the required operands are available send the instruction to corresponding execution unit if available
+            if((((currStationEntry->entry_instr->flags & INSTR_LOAD) && (mSim->reservation_stations->value2[i] != UNDEFINED)) || (currStationEntry->entry_instr->flags & INSTR_STORE)) &&
+               (currROBEntry->isAddressComputed == false))
+            {
+                if((mSim->dummy_units[mSim->curr_dummy_unit].pc == UNDEFINED) && (mSim->dummy_units[mSim->curr_dummy_unit].isAvailable == true))
+                {
+                    currROBEntry->isAddressComputed = true;
+                    mSim->dummy_units[mSim->curr_dummy_unit].rob_index = currStationEntry->destination;
+                    if(currStationEntry->entry_instr->flags & INSTR_LOAD)
+                    {
+                        mSim->dummy_units[mSim->curr_dummy_unit].pc = currStationEntry->pc;
+                        mSim->dummy_units[mSim->curr_dummy_unit].unit_instr = currStationEntry->entry_instr;
+                        mSim->dummy_units[mSim->curr_dummy_unit].isAvailable = false;
+                        //store bypassing done for this load
+                        //if(mSim->reservation_stations->value2[i] != UNDEFINED)
+                        //{
+                            mSim->dummy_units[mSim->curr_dummy_unit].output = mSim->reservation_stations->value2[i];
+                            update_instr_window(mSim, currStationEntry->pc, EXECUTE);
+                            currROBEntry->state = EXECUTE;
+                        //}
+                        mSim->dummy_units[mSim->curr_dummy_unit].reservationStationIndex = i;
+                        currStationEntry->address = mSim->reservation_stations->value1[i] + currStationEntry->address;
+                    }else
+                    {
+                        mSim->dummy_units[mSim->curr_dummy_unit].pc = currStationEntry->pc;
+                        mSim->dummy_units[mSim->curr_dummy_unit].unit_instr = currStationEntry->entry_instr;
+                        mSim->dummy_units[mSim->curr_dummy_unit].isAvailable = false;
+                        mSim->dummy_units[mSim->curr_dummy_unit].output = mSim->reservation_stations->value2[i];
+                        mSim->dummy_units[mSim->curr_dummy_unit].reservationStationIndex = i;
+                        currStationEntry->address = mSim->reservation_stations->value2[i] + currStationEntry->address;
+                        currROBEntry->destination = currStationEntry->address;
+                        mSim->dummy_units[mSim->curr_dummy_unit].output = mSim->reservation_stations->value1[i];
+                        update_instr_window(mSim, currStationEntry->pc, EXECUTE);
+                        currROBEntry->state = EXECUTE;
                     }
-                } else {
-                    //operands not yet available wait and retry next cycle
+                    mSim->curr_dummy_unit = (mSim->curr_dummy_unit + 1)%mSim->num_dummy_units;
                 }
-        }
-    }
+                continue;
+            }
+            unsigned tempUnitIndex = mSim->get_free_unit(currStationEntry->entry_instr);
+            if (tempUnitIndex != UNDEFINED)
+            {
+                //required unit is available pass the station data to the unit
+                mSim->exec_units[tempUnitIndex].pc = currStationEntry->pc;
+                mSim->exec_units[tempUnitIndex].rob_index = currStationEntry->destination;
+                currROBEntry->exe_unit = tempUnitIndex;
+                mSim->exec_units[tempUnitIndex].unit_instr = currStationEntry->entry_instr;
+                mSim->start_exec_unit(tempUnitIndex);
+                mSim->exec_units[tempUnitIndex].reservationStationIndex = i;
+                mSim->exec_units[tempUnitIndex].isAvailable = false;
+                if (currStationEntry->entry_instr->flags & INSTR_LOAD)
+                {
+                    currStationEntry->address = mSim->reservation_stations->value1[i] + currStationEntry->address;
+                }
+                update_instr_window(mSim, currStationEntry->pc, EXECUTE);
+                currROBEntry->state = EXECUTE;
 
-    //Process all exec units
-    for(int i=0; i<mSim->num_units; i++)
-    {
-        unit_t * currUnit = &mSim->exec_units[i];
-        if((currUnit->pc != UNDEFINED) && (currUnit->busy > 0))
-        {
-            currUnit->busy--;
-        }else
-        {
-            //Unit is empty nothing to do;
+            } else
+            {
+                //exec unit not yet available wait and retry next cycle
+                mSim->count_stall(STALL_FU_BUSY(currStationEntry->entry_instr->unit));
+                blame_stall(mSim, CPI_FU_BUSY(currStationEntry->entry_instr->unit), currStationEntry->destination);
+            }
         }
     }
 
@@ -1656,58 +3008,60 @@ void sim_Exe_Handler(sim_ooo * mSim)
     {
         unit_t * currUnit = &mSim->exec_units[i];
         unsigned tempDataMemAddr;
-        /*if((currUnit->pc != UNDEFINED) && (currUnit->busy == (currUnit->latency-1)) && (isLoadInstr(currUnit->unit_instr.opcode)))
-        {
-            tempDataMemAddr = mSim->reservation_stations->entries[currUnit->reservationStationIndex].value1 +
-                              mSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
-            mSim->reservation_stations->entries[currUnit->reservationStationIndex].address = tempDataMemAddr;
-        }*/
-        if((currUnit->pc != UNDEFINED) && (currUnit->busy == 0) /*&& (mSim->rob->entries[mSim->rob->get_entry_num(currUnit->pc)].state == EXECUTE)*/)
+        //the unit finishes in its completion cycle and writes the result in the next one
+        if((currUnit->pc != UNDEFINED) && (currUnit->completion <= mSim->current_cycle))
         {
+            mSim->cycle_progress = true;
             if(currUnit->type == MEMORY)
             {
-                if((currUnit->unit_instr.opcode == LW) || (currUnit->unit_instr.opcode == LWS))
+                if((currUnit->unit_instr->opcode == LW) || (currUnit->unit_instr->opcode == LWS))
                 {
                     //check if store bypassed for this load by checking if value2 is undefined or not
-                    if(mSim->reservation_stations->entries[currUnit->reservationStationIndex].value2 == UNDEFINED)
+                    if((mSim->reservation_stations->value2[currUnit->reservationStationIndex] == UNDEFINED) && (mSim->trace != NULL))
+                    {
+                        //decoupled mode: the loaded value comes from the trace
+                        currUnit->output = mSim->trace_records[currUnit->rob_index].value;
+                    } else if(mSim->reservation_stations->value2[currUnit->reservationStationIndex] == UNDEFINED)
                     {
                         tempDataMemAddr = mSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
                         if (tempDataMemAddr < mSim->data_memory_size) {
-                            currUnit->output = char2unsigned(&mSim->data_memory[tempDataMemAddr]);
+                            currUnit->output = mSim->data_memory.load_word(tempDataMemAddr);
                         } else {
                             //std::cout << "\n//TODO: error handling invalid data mem address";
                         }
                     } else
                     {
-                        currUnit->output = mSim->reservation_stations->entries[currUnit->reservationStationIndex].value2;
+                        currUnit->output = mSim->reservation_stations->value2[currUnit->reservationStationIndex];
                     }
 
-                }else if((currUnit->unit_instr.opcode == SW) || (currUnit->unit_instr.opcode == SWS))
+                }else if((currUnit->unit_instr->opcode == SW) || (currUnit->unit_instr->opcode == SWS))
                 {
                     unsigned regVal;
                     unsigned tempAddr;
                     //SW(S) enters exe twice once for addr and another time for actual mem access
                     //use state var to identify which access and perform the required action
-                    if(currSim->rob->entries[currSim->rob->get_entry_num(currUnit->pc)].state == EXECUTE)
+                    if(mSim->rob->entries[currUnit->rob_index].state == EXECUTE)
                     {
                         //SW first EXE access
                         /*station address = station value2 + station address(immediate val)*/
-                        currSim->reservation_stations->entries[currUnit->reservationStationIndex].address = currSim->reservation_stations->entries[currUnit->reservationStationIndex].value2 + currSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
-                        currSim->rob->entries[currSim->rob->get_entry_num(currUnit->pc)].destination = currSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
-                        currUnit->output = currSim->reservation_stations->entries[currUnit->reservationStationIndex].value1;
+                        mSim->reservation_stations->entries[currUnit->reservationStationIndex].address = mSim->reservation_stations->value2[currUnit->reservationStationIndex] + mSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
+                        mSim->rob->entries[currUnit->rob_index].destination = mSim->reservation_stations->entries[currUnit->reservationStationIndex].address;
+                        currUnit->output = mSim->reservation_stations->value1[currUnit->reservationStationIndex];
                     }else
                     {
                         //ROB value field contains the store address
                         //SW second EXE access
-                        tempAddr = mSim->rob->entries[mSim->rob->get_entry_num(currUnit->pc)].destination;
-                        regVal = mSim->rob->entries[mSim->rob->get_entry_num(currUnit->pc)].value;
-                        if (tempAddr < mSim->data_memory_size) {
-                            unsigned2char(regVal, &mSim->data_memory[tempAddr]);
+                        tempAddr = mSim->rob->entries[currUnit->rob_index].destination;
+                        regVal = mSim->rob->entries[currUnit->rob_index].value;
+                        if (mSim->trace != NULL) {
+                            //decoupled mode: the functional executor has written the memory
+                        } else if (tempAddr < mSim->data_memory_size) {
+                            mSim->data_memory.store_word(tempAddr, regVal);
                         } else {
                             //std::cout << "\n//TODO: invalid data memory address";
                         }
                         //release
-                        currUnit->pc = UNDEFINED;
+                        mSim->release_exec_unit(i);
                         currUnit->isAvailable = true;
                         if (!mSim->rob->pop()) {
                             //std::cout << "\n//TODO: error handling SW ROB pop failure";
@@ -1721,18 +3075,22 @@ void sim_Exe_Handler(sim_ooo * mSim)
             }else
             {
                 //if exec unit is processing branch instruction then store the branch address to the output
-                if(currUnit->unit_instr.opcode == JUMP)
+                if(mSim->trace != NULL)
+                {
+                    //decoupled mode: the result (the next PC for branches) comes from the trace
+                    currUnit->output = mSim->trace_records[currUnit->rob_index].value;
+                }else if(currUnit->unit_instr->opcode == JUMP)
                 {
-                    currUnit->output = alu(currUnit->unit_instr.opcode, UNDEFINED, UNDEFINED, mSim->reservation_stations->entries[currUnit->reservationStationIndex].value1, currUnit->pc);
-                }else if(is_branch(currUnit->unit_instr.opcode))
+                    currUnit->output = alu(currUnit->unit_instr->opcode, UNDEFINED, UNDEFINED, mSim->reservation_stations->value1[currUnit->reservationStationIndex], currUnit->pc);
+                }else if(currUnit->unit_instr->flags & INSTR_BRANCH)
                 {
-                    currUnit->output = alu(currUnit->unit_instr.opcode, mSim->reservation_stations->entries[currUnit->reservationStationIndex].value1, UNDEFINED, mSim->reservation_stations->entries[currUnit->reservationStationIndex].entry_instr.immediate, currUnit->pc);
-                }else if(is_int_imm(currUnit->unit_instr.opcode))
+                    currUnit->output = alu(currUnit->unit_instr->opcode, mSim->reservation_stations->value1[currUnit->reservationStationIndex], UNDEFINED, mSim->reservation_stations->entries[currUnit->reservationStationIndex].entry_instr->immediate, currUnit->pc);
+                }else if(is_int_imm(currUnit->unit_instr->opcode))
                 {
-                    currUnit->output = alu(currUnit->unit_instr.opcode, mSim->reservation_stations->entries[currUnit->reservationStationIndex].value1, mSim->reservation_stations->entries[currUnit->reservationStationIndex].entry_instr.immediate, UNDEFINED,  currUnit->pc);
+                    currUnit->output = alu(currUnit->unit_instr->opcode, mSim->reservation_stations->value1[currUnit->reservationStationIndex], mSim->reservation_stations->entries[currUnit->reservationStationIndex].entry_instr->immediate, UNDEFINED,  currUnit->pc);
                 }else
                 {
-                    currUnit->output = alu(currUnit->unit_instr.opcode, mSim->reservation_stations->entries[currUnit->reservationStationIndex].value1, mSim->reservation_stations->entries[currUnit->reservationStationIndex].value2, UNDEFINED, currUnit->pc);
+                    currUnit->output = alu(currUnit->unit_instr->opcode, mSim->reservation_stations->value1[currUnit->reservationStationIndex], mSim->reservation_stations->value2[currUnit->reservationStationIndex], UNDEFINED, currUnit->pc);
                 }
             }
 
@@ -1744,76 +3102,57 @@ void sim_Exe_Handler(sim_ooo * mSim)
 }
 void sim_WB_Handler(sim_ooo * mSim)
 {
+    HOST_PROFILE_SCOPE(mSim, HOST_WB);
     for(int i=0; i < mSim->num_units; i++)
     {
         unit_t *currUnit = &mSim->exec_units[i];
-        if (isValidPC(currUnit->pc) && (currUnit->busy == 0))
+        if (mSim->isValidPC(currUnit->pc) && (currUnit->completion < mSim->current_cycle))
         {
-            currSim->rob->entries[currSim->rob->get_entry_num(currUnit->pc)].state = WRITE_RESULT;
-            update_instr_window(currUnit->pc, WRITE_RESULT);
+            mSim->rob->entries[currUnit->rob_index].state = WRITE_RESULT;
+            update_instr_window(mSim, currUnit->pc, WRITE_RESULT);
             mSim->CDB_write(mSim->reservation_stations->entries[currUnit->reservationStationIndex].destination,currUnit->output);
             //release execution unit and reservation station entry
-            currUnit->pc = UNDEFINED;
-            clean_res_station(&mSim->reservation_stations->entries[currUnit->reservationStationIndex]);
+            mSim->release_exec_unit(i);
+            mSim->reservation_stations->release_station(currUnit->reservationStationIndex);
         }
     }
-    for(int i=0;i<mNumDummyUnits;i++) {
-        if (isValidPC(mDummyExeUnit[i].pc))
+    for(int i=0;i<mSim->num_dummy_units;i++) {
+        if (mSim->isValidPC(mSim->dummy_units[i].pc))
         {
-            res_station_entry_t *currStation;
-            currStation = &mSim->reservation_stations->entries[mDummyExeUnit[i].reservationStationIndex];
-            if (((isLoadInstr(mDummyExeUnit[i].unit_instr.opcode)) && (currStation->value2 != UNDEFINED)) ||
-                ((mDummyExeUnit[i].unit_instr.opcode == SW) || (mDummyExeUnit[i].unit_instr.opcode == SWS))) {
-                currSim->rob->entries[currSim->rob->get_entry_num(mDummyExeUnit[i].pc)].state = WRITE_RESULT;
-                update_instr_window(mDummyExeUnit[i].pc, WRITE_RESULT);
-                mSim->CDB_write(mSim->reservation_stations->entries[mDummyExeUnit[i].reservationStationIndex].destination,
-                                mDummyExeUnit[i].output);
+            if (((mSim->dummy_units[i].unit_instr->flags & INSTR_LOAD) && (mSim->reservation_stations->value2[mSim->dummy_units[i].reservationStationIndex] != UNDEFINED)) ||
+                (mSim->dummy_units[i].unit_instr->flags & INSTR_STORE)) {
+                mSim->rob->entries[mSim->dummy_units[i].rob_index].state = WRITE_RESULT;
+                update_instr_window(mSim, mSim->dummy_units[i].pc, WRITE_RESULT);
+                if(mSim->dummy_units[i].unit_instr->flags & INSTR_STORE)
+                {
+                    mSim->lsq->forwarding_stores.set(mSim->dummy_units[i].rob_index);
+                }
+                mSim->CDB_write(mSim->reservation_stations->entries[mSim->dummy_units[i].reservationStationIndex].destination,
+                                mSim->dummy_units[i].output);
 
                 //release execution unit and reservation station entry
-                clean_res_station(&mSim->reservation_stations->entries[mDummyExeUnit[i].reservationStationIndex]);
+                mSim->reservation_stations->release_station(mSim->dummy_units[i].reservationStationIndex);
             }
-            mCurrDummyUnitIndex--;
-            mDummyExeUnit[i].pc = UNDEFINED;
-            mDummyExeUnit[i].isAvailable = true;
+            mSim->curr_dummy_unit--;
+            mSim->dummy_units[i].pc = UNDEFINED;
+            mSim->cycle_progress = true;
+            mSim->dummy_units[i].isAvailable = true;
         }
     }
-    for(int i=0; i<mSim->rob->num_entries;i++)
+    //stores in WRITE_RESULT forward their data to the younger loads (in ROB slot order)
+    for(unsigned w=0; w<mSim->lsq->forwarding_stores.num_words; w++)
     {
-        instruction_t currInstr = mSim->rob->entries[i].entry_instr;
-        if((currInstr.opcode == SW) || (currInstr.opcode == SWS))
+        for(unsigned long long mBits = mSim->lsq->forwarding_stores.words[w]; mBits != 0; mBits &= (mBits - 1))
         {
-            if(mSim->rob->entries[i].state == WRITE_RESULT)
-            {
-                store_bypassing_wb_handler(mSim->rob->entries[i].pc);
-            }
+            store_bypassing_wb_handler(mSim, w*64 + __builtin_ctzll(mBits));
         }
     }
 }
 void sim_Commit_Handler(sim_ooo * mSim)
 {
-    //workaround to make rob entries, reservation stations and exe units available for exe in the next clock cycle
-    for(int i=0; i < mSim->num_units; i++)
-    {
-        unit_t *currUnit = &mSim->exec_units[i];
-        if(currUnit->pc == UNDEFINED)
-        {
-            currUnit->isAvailable = true;
-        }
-    }
-    for(int i=0; i < mSim->reservation_stations->num_entries; i++)
-    {
-        if(mSim->reservation_stations->entries[i].pc == UNDEFINED)
-        {
-            mSim->reservation_stations->entries[i].isAvailable = true;
-        }
-    }
-    for(int i=0; i<mSim->rob->num_entries; i++)
-    {
-        if(mSim->rob->entries[i].pc == UNDEFINED)
-        {
-            mSim->rob->entries[i].isAvailable = true;
-        }
-    }
+    HOST_PROFILE_SCOPE(mSim, HOST_COMMIT);
+    //rob entries, reservation stations and exe units released in the previous clock cycle become available now
+    mSim->process_releases();
     rob_entry_t * currHead;
     for(int i=0; i < 1/*mSim->issue_width*/; i++)
     {
@@ -1826,25 +3165,32 @@ void sim_Commit_Handler(sim_ooo * mSim)
             }
             //SW(S) enters exe twice once for addr and another time for actual mem access
             //use state var to identify which access and perform the required action
-            if (((currHead->entry_instr.opcode == SW) || (currHead->entry_instr.opcode == SWS)))
+            if (currHead->entry_instr->flags & INSTR_STORE)
             {
                 if(currHead->state == WRITE_RESULT)
                 {
                     //check if SW(s) is already being executed
-                    if (search_exe_unit(currHead->pc) == UNDEFINED) {
+                    if (search_exe_unit(mSim, currHead->pc) == UNDEFINED) {
                         unsigned tempExeUnitIndex;
                         ////std::cout << "\n//TODO:store handling";
-                        tempExeUnitIndex = currSim->get_free_unit(currHead->entry_instr.opcode);
+                        tempExeUnitIndex = mSim->get_free_unit(currHead->entry_instr);
                         //check if required exe unit is available
                         if (tempExeUnitIndex != UNDEFINED) {
-                            currSim->exec_units[tempExeUnitIndex].pc = currHead->pc;
-                            currSim->exec_units[tempExeUnitIndex].unit_instr = currHead->entry_instr;
-                            currSim->exec_units[tempExeUnitIndex].busy = currSim->exec_units[tempExeUnitIndex].latency;
-                            currSim->exec_units[tempExeUnitIndex].reservationStationIndex = currSim->rob->get_head_index();
-                            mSim->rob->entries[mSim->rob->get_entry_num(currHead->pc)].state = COMMIT;
-                            update_instr_window(currHead->pc, COMMIT);
-                            mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_entry_num(currHead->pc)]);
-
+                            mSim->exec_units[tempExeUnitIndex].pc = currHead->pc;
+                            mSim->exec_units[tempExeUnitIndex].rob_index = mSim->rob->get_head_index();
+                            currHead->exe_unit = tempExeUnitIndex;
+                            mSim->exec_units[tempExeUnitIndex].unit_instr = currHead->entry_instr;
+                            mSim->start_exec_unit(tempExeUnitIndex);
+                            mSim->exec_units[tempExeUnitIndex].reservationStationIndex = mSim->rob->get_head_index();
+                            currHead->state = COMMIT;
+                            mSim->lsq->forwarding_stores.clear(mSim->rob->get_head_index());
+                            update_instr_window(mSim, currHead->pc, COMMIT);
+                            mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_head_index()]);
+                            mSim->cycle_commit = true;
+                            mSim->flushing = false;
+                        } else {
+                            mSim->count_stall(STALL_STORE_COMMIT);
+                            blame_stall(mSim, CPI_FU_BUSY(MEMORY), mSim->rob->get_head_index());
                         }
                     } else {
                         //Do Nothing SW is already being committed wait...
@@ -1854,67 +3200,30 @@ void sim_Commit_Handler(sim_ooo * mSim)
             } else if (currHead->ready)
             {
                 mSim->instructions_executed++;
-                update_instr_window(currHead->pc, COMMIT);
-                //mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_entry_num(currHead->pc)]);
-                if (is_branch(currHead->entry_instr.opcode)) {
+                mSim->cycle_commit = true;
+                mSim->flushing = false;
+                update_instr_window(mSim, currHead->pc, COMMIT);
+                //mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_head_index()]);
+                if (currHead->entry_instr->flags & INSTR_BRANCH) {
                     if (currHead->value == currHead->pc + 4) {
                         //Do Nothing branch not taken
-                        mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_entry_num(currHead->pc)]);
+                        mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_head_index()]);
                         if (!mSim->rob->pop()) {
                             //std::cout << "\n//TODO: error handling pop failure at commit clearing buffer";
                         }
                     } else {
-                        //Branch mis prediction handling
-                        sim_WB_Handler(mSim);
-                        sim_Exe_Handler(mSim);
-                        sim_Issue_Handler(mSim);
-                        int n=0;
-                        for(int i=mSim->rob->get_head_index();n<mSim->rob->currLength;i=(i+1)%mSim->rob->num_entries,n++)
-                        {
-                            mSim->commit_to_log(mSim->pending_instructions.entries[i]);
-                        }
-                        isBranchMispredicted = true;
-                        mSim->PC = currHead->value;
-                        if (!isValidPC(mSim->PC)) {
-                            //std::cout << "\n//TODO: error handling invalid PC loaded at commit";
-                        }
-                        //Clear ROB
-                        while (!mSim->rob->isEmpty()) {
-                            if (!mSim->rob->pop()) {
-                                //std::cout << "\n//TODO: error handling pop failure at commit clearing buffer";
-                            }
-                        }
-                        mSim->rob->headIndex = 0;
-                        mSim->rob->tailIndex = 0;
-
-                        for(int i=0; i<mSim->rob->num_entries; i++)
-                        {
-                            mSim->rob->entries[i].isAvailable = true;
-                        }
-                        //Clear Exec units
-                        for (int i = 0; i < mSim->num_units; i++) {
-                            mSim->exec_units[i].pc = UNDEFINED;
-                            mSim->exec_units[i].busy = 0;
-                            mSim->exec_units[i].isAvailable = true;
-                        }
-                        //Clear reservation stations
-                        for (int i = 0; i < mSim->reservation_stations->num_entries; i++) {
-                            clean_res_station(&mSim->reservation_stations->entries[i]);
-                            mSim->reservation_stations->entries[i].isAvailable = true;
-                        }
-                        for(int i = 0;i<NUM_GP_REGISTERS;i++)
-                        {
-                            mSim->int_reg_file[i].tag = UNDEFINED;
-                            mSim->fp_reg_file[i].tag = UNDEFINED;
-                        }
+                        //Branch mis prediction handling: the rest of the clock cycle proceeds
+                        //as usual, the younger instructions are squashed at its end
+                        mSim->redirect_pc = currHead->value;
+                        mSim->cycle_progress = true;
                         break;
                     }
 
-                } else if (isOpcodeFpType(currHead->entry_instr.opcode)) {
-                    mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_entry_num(currHead->pc)]);
+                } else if (currHead->entry_instr->flags & INSTR_FP) {
+                    mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_head_index()]);
                     mSim->fp_reg_file[currHead->destination].val = currHead->value;
                     //clear tag if it corresponds to the  current ROB entry
-                    if (mSim->fp_reg_file[currHead->destination].tag == mSim->rob->get_entry_num(currHead->pc)) {
+                    if (mSim->fp_reg_file[currHead->destination].tag == mSim->rob->get_head_index()) {
                         mSim->fp_reg_file[currHead->destination].tag = UNDEFINED;
                     }
                     //release rob entry
@@ -1922,10 +3231,10 @@ void sim_Commit_Handler(sim_ooo * mSim)
                         //std::cout << "\n//TODO: error handling pop failure";
                     }
                 } else {
-                    mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_entry_num(currHead->pc)]);
+                    mSim->commit_to_log(mSim->pending_instructions.entries[mSim->rob->get_head_index()]);
                     mSim->int_reg_file[currHead->destination].val = currHead->value;
                     //clear tag if it corresponds to the  current ROB entry
-                    if (mSim->int_reg_file[currHead->destination].tag == mSim->rob->get_entry_num(currHead->pc)) {
+                    if (mSim->int_reg_file[currHead->destination].tag == mSim->rob->get_head_index()) {
                         mSim->int_reg_file[currHead->destination].tag = UNDEFINED;
                     }
                     //release rob entry
@@ -1946,9 +3255,14 @@ void sim_Commit_Handler(sim_ooo * mSim)
     }
 }
 
-inline bool isValidPC(unsigned mPC)
+bool sim_ooo::isValidPC(unsigned mPC)
+{
+    return ((mPC >= instr_base_address) && ((mPC - instr_base_address) / 4 < instr_memory_size));
+}
+
+void sim_ooo::set_output(ostream &os)
 {
-    return ((mPC >= mBaseAddr) && (mPC < (mBaseAddr + (4*PROGRAM_SIZE))));
+    output = &os;
 }
 
 inline bool isLoadInstr(opcode_t mOpCode)
@@ -1961,186 +3275,94 @@ inline bool isStoreInstr(opcode_t mOpCode)
     return ((mOpCode ==  SW) || (mOpCode == SWS));
 }
 
-unsigned search_exe_unit(unsigned mPC)
+unsigned search_exe_unit(sim_ooo * mSim, unsigned mPC)
 {
     unsigned mRetVal = UNDEFINED;
-    if(isValidPC(mPC))
+    unsigned mROBIndex = mSim->rob->get_entry_num(mPC);
+    if(mROBIndex != UNDEFINED)
     {
-        for(int i=0;i<currSim->num_units;i++)
+        //the ROB entry records the last unit the instruction was sent to
+        unsigned i = mSim->rob->entries[mROBIndex].exe_unit;
+        if((i != UNDEFINED) && (mSim->exec_units[i].pc == mPC))
         {
-            if(currSim->exec_units[i].pc == mPC)
-            {
-                mRetVal = i;
-                break;
-            }
+            mRetVal = i;
         }
     }
 
     return mRetVal;
 }
 
-unsigned search_prev_load_store(res_station_entry_t * mStation)
+
+//blames the stall of the current clock cycle on "mComponent" if the instruction in ROB entry
+//"mROBIndex" is the oldest one held so far in the cycle
+void blame_stall(sim_ooo * mSim, unsigned mComponent, unsigned mROBIndex)
 {
-    unsigned mRetval = UNDEFINED;
-    unsigned mROBIndex = currSim->rob->get_entry_num(mStation->pc);
-    rob_entry_t * mROBEntry = &currSim->rob->entries[mROBIndex];
-    for(int i=currSim->rob->get_head_index(); i!=mROBIndex;i=(i+1)%currSim->rob->num_entries)
+    unsigned mHead = mSim->rob->headIndex;
+    unsigned mAge = (mROBIndex >= mHead) ? mROBIndex - mHead : mROBIndex + mSim->rob->num_entries - mHead;
+    if(mAge < mSim->cycle_stall_age)
     {
-        rob_entry_t * currROBEntry = &currSim->rob->entries[i];
-        res_station_entry_t * currStation = &currSim->reservation_stations->entries[currSim->reservation_stations->get_station_num(currROBEntry->pc)];
-        if(isStoreInstr(currROBEntry->entry_instr.opcode))
-        {
-            //if(isLoadInstr(mStation->entry_instr.opcode))
-
-            if (currROBEntry->state == ISSUE)
-            {
-                if ((currStation->tag2 == UNDEFINED) && (currStation->CDBWriteDataAvailClkCyclevalue2 < (int)currClkCycle))
-                {
-                    unsigned temp1Addr;
-                    if(isLoadInstr(mStation->entry_instr.opcode))
-                    {
-                        temp1Addr = mStation->value1 + mStation->entry_instr.immediate;
-                    } else if(isStoreInstr(mStation->entry_instr.opcode))
-                    {
-                        temp1Addr = mStation->value2 + mStation->entry_instr.immediate;
-                    }
-                    if ((currStation->value2 + currStation->entry_instr.immediate) == temp1Addr)
-                    {
-                        mRetval = i;
-                        break;
-                    }
-                } else
-                {
-                    mRetval = i;
-                    break;
-                }
-            } else if (currROBEntry->state == EXECUTE)
-            {
-                unsigned temp1Addr;
-                if(isLoadInstr(mStation->entry_instr.opcode))
-                {
-                    temp1Addr = mStation->value1 + mStation->entry_instr.immediate;
-                } else if(isStoreInstr(mStation->entry_instr.opcode))
-                {
-                    temp1Addr = mStation->value2 + mStation->entry_instr.immediate;
-                }
-                if ((currStation->address) == temp1Addr)
-                {
-                    mRetval = i;
-                    break;
-                }
-            } else {
-                //Do Nothing
-            }
-
-        }/* else if(isLoadInstr(currROBEntry->entry_instr.opcode))
-        {
-            if(isStoreInstr(mStation->entry_instr.opcode))
-            {
-                if(currROBEntry->state == ISSUE)
-                {
-                    if (currStation->tag1 == UNDEFINED)
-                    {
-                        unsigned temp1Addr;
-                        temp1Addr = currStation->value1 + currStation->entry_instr.immediate;
-                        if ((temp1Addr) == (mStation->value2 + mStation->entry_instr.immediate))
-                        {
-                            mRetval = i;
-                            break;
-                        }
-                    } else
-                    {
-                        mRetval = i;
-                        break;
-                    }
-                }else if(currROBEntry->state == EXECUTE)
-                {
-                    if((currStation->address) == (mStation->value2 + mStation->entry_instr.immediate))
-                    {
-                        mRetval = i;
-                        break;
-                    }
-                }else
-                {
-                    //Do Nothing
-                }
-
-            }
-        }*/
-
+        mSim->cycle_stall_age = mAge;
+        mSim->cycle_stall = mComponent;
     }
-    return mRetval;
-
 }
 
-void update_instr_window(unsigned mPC, stage_t mStage)
+void update_instr_window(sim_ooo * mSim, unsigned mPC, stage_t mStage)
 {
-    if(isValidPC(mPC))
+    if(mSim->isValidPC(mPC))
     {
-            for (int i = 0; i < currSim->pending_instructions.num_entries; i++)
+            mSim->cycle_progress = true;
+            //the instruction window is indexed like the ROB
+            unsigned i = mSim->rob->get_entry_num(mPC);
+            if (i != UNDEFINED)
             {
-                if (currSim->pending_instructions.entries[i].pc == mPC)
-                {
-                    switch (mStage) {
-                        case ISSUE:
-                            currSim->pending_instructions.entries[i].issue = currClkCycle;
-                            break;
-                        case EXECUTE:
-                            currSim->pending_instructions.entries[i].exe = currClkCycle;
-                            break;
-                        case WRITE_RESULT:
-                            currSim->pending_instructions.entries[i].wr = currClkCycle;
-                            break;
-                        case COMMIT:
-                            currSim->pending_instructions.entries[i].commit = currClkCycle;
-                            break;
-                        default:
-                            //std::cout << "\n//TODO: error handling invalid stage";
-                            break;
-                    }
-                    break;
+                switch (mStage) {
+                    case ISSUE:
+                        mSim->pending_instructions.entries[i].issue = mSim->current_cycle;
+                        break;
+                    case EXECUTE:
+                        mSim->pending_instructions.entries[i].exe = mSim->current_cycle;
+                        break;
+                    case WRITE_RESULT:
+                        mSim->pending_instructions.entries[i].wr = mSim->current_cycle;
+                        break;
+                    case COMMIT:
+                        mSim->pending_instructions.entries[i].commit = mSim->current_cycle;
+                        break;
+                    default:
+                        //std::cout << "\n//TODO: error handling invalid stage";
+                        break;
                 }
             }
     }
 }
 
-void store_bypassing_wb_handler(unsigned mPC)
+void store_bypassing_wb_handler(sim_ooo * mSim, unsigned mROBIndex)
 {
-    if(isValidPC(mPC))
+    unsigned mPC = mSim->rob->entries[mROBIndex].pc;
+    if(mSim->isValidPC(mPC))
     {
-        instruction_t currInstr = currSim->instr_memory[(mPC - currSim->instr_base_address)/4];
+        const instruction_t &currInstr = mSim->instr_memory[(mPC - mSim->instr_base_address)/4];
         if((currInstr.opcode == SW) || (currInstr.opcode == SWS))
         {
-            unsigned currStoreROBIndex = currSim->rob->get_entry_num(mPC);
-            unsigned i = (currStoreROBIndex + 1)%currSim->rob->num_entries;
-            if(i != currSim->rob->get_tail_index())
+            Load_Store_Queue * lsq = mSim->lsq;
+            //ROB destination field contains the store address
+            unsigned mAddr = mSim->rob->entries[mROBIndex].destination;
+            unsigned mStoreAge = lsq->age(mROBIndex);
+            unsigned i = lsq->buckets[lsq->load_bucket(mAddr)];
+            while(i != UNDEFINED)
             {
-                for(;i != currSim->rob->tailIndex; i = (i + 1)%currSim->rob->num_entries)
+                unsigned mNext = lsq->next[i];
+                //only loads holding a station and still waiting for their data are chained
+                if((lsq->address[i] == mAddr) && (lsq->age(i) > mStoreAge))
                 {
-                    rob_entry_t * currROBEntry = &currSim->rob->entries[i];
-                    instruction_t currROBInstr = currROBEntry->entry_instr;
-                    if(isLoadInstr(currROBInstr.opcode))
-                    {
-                        unsigned currLoadStationIndex;
-                        currLoadStationIndex = currSim->reservation_stations->get_station_num(currROBEntry->pc);
-                        if(currLoadStationIndex != UNDEFINED) {
-                            res_station_entry_t *currStation = &currSim->reservation_stations->entries[currLoadStationIndex];
-                            //this function is called after checking tags so values of stations should be available
-                            if ((currStation->value1 + currROBInstr.immediate) ==
-                                (currSim->rob->entries[currStoreROBIndex].destination)) {
-                                if(currStation->value2 == UNDEFINED) {
-                                    currStation->value2 = currSim->rob->entries[currStoreROBIndex].value;
-                                    currStation->CDBWriteDataAvailClkCycle = currSim->pending_instructions.entries[currSim->rob->get_entry_num(mPC)].wr;
-                                }
-                            }
-                        }
-                    }
+                    unsigned currLoadStationIndex = mSim->rob->entries[i].station;
+                    mSim->cycle_progress = true;
+                    mSim->reservation_stations->value2[currLoadStationIndex] = mSim->rob->entries[mROBIndex].value;
+                    mSim->reservation_stations->CDBWriteDataAvailClkCycle[currLoadStationIndex] = mSim->pending_instructions.entries[mROBIndex].wr;
+                    lsq->remove(i);
                 }
-            }else
-            {
-                //do nothing
+                i = mNext;
             }
-
         }else
         {
             //std::cout << "\n//TODO: error handling invalid opcode for this function";
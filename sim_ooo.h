@@ -6,15 +6,20 @@
 #include <string>
 #include <cstring>
 #include <sstream>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include "data_memory.h"
 
 using namespace std;
 
 #define UNDEFINED 0xFFFFFFFF //constant used for initialization
+#define UNDEFINED_CYCLE 0xFFFFFFFFFFFFFFFFULL //constant used for initialization of the (64-bit) clock cycle fields
 #define NUM_GP_REGISTERS 32
 #define NUM_OPCODES 24
 #define NUM_STAGES 4
 #define MAX_UNITS 10 
-#define PROGRAM_SIZE 50 
+#define NUM_UNIT_TYPES 5
 
 // instructions supported
 typedef enum {LW, SW, ADD, ADDI, SUB, SUBI, XOR, AND, MULT, DIV, BEQZ, BNEZ, BLTZ, BGTZ, BLEZ, BGEZ, JUMP, EOP, LWS, SWS, ADDS, SUBS, MULTS, DIVS} opcode_t;
@@ -28,67 +33,188 @@ typedef enum {INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY} exe_unit_t;
 // stages names
 typedef enum {ISSUE, EXECUTE, WRITE_RESULT, COMMIT} stage_t;
 
-// instruction data type
+// instruction class bits, precomputed by parse_program
+#define INSTR_BRANCH 0x01
+#define INSTR_MEMORY 0x02
+#define INSTR_LOAD   0x04
+#define INSTR_STORE  0x08
+#define INSTR_FP     0x10
+
+// instruction data type: a plain micro-op, predecoded by parse_program. The pipeline structures
+// point to it in instruction memory rather than copying it; the branch labels are kept aside
+// (program_image_t::branch_labels) as they are only needed for printing
 typedef struct{
         opcode_t opcode; //opcode
         unsigned src1; //first source register in the assembly instruction (for SW, register to be written to memory)
         unsigned src2; //second source register in the assembly instruction
         unsigned dest; //destination register
-        unsigned immediate; //immediate field
-        string label; //for conditional branches, label of the target instruction - used only for parsing/debugging purposes
+        unsigned immediate; //immediate field (for branches, offset of the target from the next instruction)
+        unsigned target; //for branches, address of the target instruction
+        unsigned char flags; //instruction class (INSTR_* bits)
+        unsigned char unit; //execution unit type (exe_unit_t), UNDEFINED_UNIT if none
+        unsigned char station; //reservation station type (res_station_t)
 } instruction_t;
 
+#define UNDEFINED_UNIT 0xFF
+
+// bytes of a program image loaded in data memory at "address" (see the data directives in parse_program)
+typedef struct{
+        unsigned address;
+        vector<unsigned char> bytes;
+} data_segment_t;
+
+// program image: an assembly program parsed and predecoded for a given base address. It is not
+// modified once parsed, so one image can be loaded by any number of simulators, also concurrently.
+// The instructions are sized from the program, and always end with an EOP
+typedef struct{
+        vector<instruction_t> instructions;
+        unsigned base_address;
+        unordered_map<unsigned, string> branch_labels; //label of the target of each branch instruction
+        vector<data_segment_t> data; //initial content of the data memory, written by load_program
+        vector<string> source; //lines of the assembly file, for the annotated listings (see print_profile)
+        vector<unsigned> source_line; //line of each instruction in "source" (UNDEFINED for the final EOP)
+} program_image_t;
+
+//empties a program image (a single EOP instruction)
+void clear_program_image(program_image_t *image);
+
+//parses the assembly program in file "filename" into a program image for the given base address.
+//Besides the instructions, the program can hold data directives (one per line, values separated
+//by spaces or commas), which place little-endian data at a location counter starting at 0:
+//  .data [address]     moves the location counter to "address"
+//  .word value...      32-bit integers (decimal, 0x hexadecimal or 0 octal, possibly negative)
+//  .float value...     single precision floats
+//  .space bytes        skips "bytes" bytes (left at the reset value 0xFF)
+void parse_program(const char *filename, unsigned base_address, program_image_t *image);
+
+//returns the assembly text of a predecoded instruction (branch targets as addresses)
+string disassemble(const instruction_t &instr);
+
+//bits of a single precision float (a floating point register, a data memory word) as a float, and back
+inline float bits2float(unsigned bits){
+	float value;
+	memcpy(&value, &bits, sizeof value);
+	return value;
+}
+
+inline unsigned float2bits(float value){
+	unsigned bits;
+	memcpy(&bits, &value, sizeof bits);
+	return bits;
+}
+
+//implements the ALU operation (loads and stores excluded); for branches, returns the next PC.
+//Defined here so that a caller with a constant opcode (see interpreter.cc) is left with the
+//operation alone
+inline unsigned alu(opcode_t opcode, unsigned value1, unsigned value2, unsigned immediate, unsigned pc){
+	switch(opcode){
+		case ADD:
+		case ADDI:
+			return value1 + value2;
+		case SUB:
+		case SUBI:
+			return value1 - value2;
+		case XOR:
+			return value1 ^ value2;
+		case AND:
+			return value1 & value2;
+		case MULT:
+			return value1 * value2;
+		case DIV:
+			return value1 / value2;
+		case ADDS:
+			return float2bits(bits2float(value1) + bits2float(value2));
+		case SUBS:
+			return float2bits(bits2float(value1) - bits2float(value2));
+		case MULTS:
+			return float2bits(bits2float(value1) * bits2float(value2));
+		case DIVS:
+			return float2bits(bits2float(value1) / bits2float(value2));
+		case JUMP:
+			return pc + 4 + immediate;
+		default:{ //branches
+			int reg = (int) value1;
+			bool condition = ((opcode == BEQZ && reg == 0) ||
+					  (opcode == BNEZ && reg != 0) ||
+					  (opcode == BGEZ && reg >= 0) ||
+					  (opcode == BLEZ && reg <= 0) ||
+					  (opcode == BGTZ && reg > 0) ||
+					  (opcode == BLTZ && reg < 0));
+			return condition ? pc + 4 + immediate : pc + 4;
+		}
+	}
+}
+
+// record of an instruction in a functional trace (see functional.h)
+typedef struct{
+	unsigned pc;
+	unsigned value;      // result written to the destination register, stored value for stores, next PC for branches
+	unsigned address;    // effective address of loads and stores (UNDEFINED otherwise)
+	unsigned wrong_path; // for taken branches, number of wrong-path records following this one
+} trace_record_t;
+
+class Trace_Ring;
+class Log_Writer;
+class Pipeview_Writer;
+class Instruction_Profile;
+class Host_Profile;
+class Interpreter;
+class Checkpoint_Stream;
+
 // execution unit
 typedef struct{
         exe_unit_t type;  // execution unit type
         unsigned latency; // execution unit latency
-        unsigned busy;    // 0 if execution unit is free, otherwise number of clock cycles during
-                          // which the execution unit will be busy. It should be initialized
-                          // to the latency of the unit when the unit becomes busy, and decremented
-                          // at each clock cycle
+        unsigned long long completion; // clock cycle in which the execution unit finishes the instruction
+                             // (the result is written to the CDB in the following cycle). It is
+                             // scheduled on the timing wheel when the unit becomes busy, so no
+                             // per-cycle countdown is needed
         unsigned pc; 	  // PC of the instruction using the functional unit
-        instruction_t unit_instr;
+        const instruction_t *unit_instr;
         unsigned output;
         unsigned reservationStationIndex;
+        unsigned rob_index; // ROB entry (tag) of the instruction using the unit
         bool isAvailable;
 } unit_t;
 
 // entry in the "instruction window"
+// (the clock cycles are UNDEFINED_CYCLE until the instruction reaches the stage)
 typedef struct{
 	unsigned pc;	// PC of the instruction
-	unsigned issue;	// clock cycle when the instruction is issued
-	unsigned exe;	// clock cycle when the instruction enters execution
-	unsigned wr;	// clock cycle when the instruction enters write result
-	unsigned commit;// clock cycle when the instruction commits (for stores, clock cycle when the store starts committing 
+	unsigned long long issue;	// clock cycle when the instruction is issued
+	unsigned long long exe;	// clock cycle when the instruction enters execution
+	unsigned long long wr;	// clock cycle when the instruction enters write result
+	unsigned long long commit;// clock cycle when the instruction commits (for stores, clock cycle when the store starts committing 
 } instr_window_entry_t;
 
+//prints the header and one instruction of the execution log
+void print_log_header(ostream &log);
+void print_log_entry(ostream &log, const instr_window_entry_t &entry);
+
 // ROB entry
 typedef struct{
 	bool ready;	// ready field
 	unsigned pc;  	// pc of corresponding instruction (set to UNDEFINED if ROB entry is available)
-    instruction_t entry_instr;
+    const instruction_t *entry_instr;
 	stage_t state;	// state field
 	unsigned destination; // destination field
 	unsigned value;	      // value field
     bool isAvailable;
     bool isAddressComputed; //relevant only for LW(S)/SW(S)
+    unsigned station;     // reservation station of the instruction (UNDEFINED if none)
+    unsigned exe_unit;    // execution unit the instruction was last sent to (UNDEFINED if none)
 }rob_entry_t;
 
-// reservation station entry
+// reservation station entry; the fields read by the wakeup/select logic (type, Vj, Vk,
+// Qj, Qk and the CDB write cycle) live in parallel arrays of Reservation_Stations
 typedef struct{
-	res_station_t type; // reservation station type
 	unsigned name;	    // reservation station name (i.e., "Int", "Add", "Mult", "Load") for logging purposes
 	unsigned pc;  	    // pc of corresponding instruction (set to UNDEFINED if reservation station is available)
-	instruction_t entry_instr;
-    unsigned value1;    // Vj field
-	unsigned value2;    // Vk field
-	unsigned tag1;	    // Qj field
-	unsigned tag2;	    // Qk field
-	unsigned destination; // destination field
+	const instruction_t *entry_instr;
+	unsigned destination; // destination field (ROB entry, i.e. tag, of the instruction)
 	unsigned address;     // address field (for loads and stores)
     bool isAvailable;
-    int CDBWriteDataAvailClkCycle;
-    int CDBWriteDataAvailClkCyclevalue2;  //only for store
+    long long CDBWriteDataAvailClkCyclevalue2;  //only for store
 }res_station_entry_t;
 
 //instruction window 
@@ -101,6 +227,45 @@ typedef struct {
     unsigned val;
     unsigned tag;
 }reg_file_element_t;
+
+// kinds of resources whose release is deferred to the next clock cycle
+typedef enum {RELEASE_ROB, RELEASE_STATION, RELEASE_UNIT} release_t;
+
+// entry of the deferred-release queue
+typedef struct {
+    release_t kind;
+    unsigned index;
+}release_entry_t;
+
+// components of the CPI stack: every simulated clock cycle is attributed to exactly one of them
+// (see sim_ooo::account_cycles), so that they add up to the clock cycles
+#define CPI_BASE            0                               // an instruction committed, or nothing stalled
+#define CPI_ROB_FULL        1                               // issue stopped on a full ROB
+#define CPI_RS_FULL(rs)     (2 + (rs))                      // issue stopped on the stations of a res_station_t
+#define CPI_FU_BUSY(unit)   (2 + MAX_RS + (unit))           // a ready instruction found no free unit of an exe_unit_t
+#define CPI_MEMORY_ORDER    (2 + MAX_RS + NUM_UNIT_TYPES)   // a load held behind an older store to its address
+#define CPI_BRANCH_FLUSH    (3 + MAX_RS + NUM_UNIT_TYPES)   // refilling the pipeline after a mispredicted branch
+#define NUM_CPI_COMPONENTS  (4 + MAX_RS + NUM_UNIT_TYPES)
+
+// stall events counted at the decision points of the handlers
+#define STALL_ROB_FULL      0                               // issue stopped on a full ROB
+#define STALL_RS_FULL(rs)   (1 + (rs))                      // issue stopped on the stations of a res_station_t
+#define STALL_OPERANDS      (1 + MAX_RS)                    // a station waiting for its operands (per station and cycle)
+#define STALL_FU_BUSY(unit) (2 + MAX_RS + (unit))           // a ready instruction found no free unit of an exe_unit_t
+#define STALL_MEMORY_ORDER  (2 + MAX_RS + NUM_UNIT_TYPES)   // a load held behind an older store to its address
+#define STALL_STORE_COMMIT  (3 + MAX_RS + NUM_UNIT_TYPES)   // a store at the ROB head waiting for a MEMORY unit
+#define STALL_BRANCH_FLUSH  (4 + MAX_RS + NUM_UNIT_TYPES)   // a mispredicted branch squashing the younger instructions
+#define NUM_STALL_EVENTS    (5 + MAX_RS + NUM_UNIT_TYPES)
+
+// names of the CPI stack components and of the stall events, as printed by print_cpi_stack
+extern const char *cpi_component_names[NUM_CPI_COMPONENTS];
+extern const char *stall_event_names[NUM_STALL_EVENTS];
+
+// performance counters (see sim_ooo::get_perf_counters)
+typedef struct {
+    unsigned long long cycles[NUM_CPI_COMPONENTS];  // clock cycles attributed to each component
+    unsigned long long events[NUM_STALL_EVENTS];    // occurrences of each stall event
+}perf_counters_t;
 // ROB
 /*
 typedef struct{
@@ -119,18 +284,41 @@ typedef struct{
 	unsigned num_entries;
 	res_station_entry_t *entries;
 }res_stations_t;*/
+//bitmask free list: bit i is set when resource i can be allocated
+class Free_List{
+public:
+    unsigned num_words;
+    unsigned long long *words;
+
+    Free_List();
+    ~Free_List();
+    void init(unsigned mSize);
+    void copy(const Free_List &other);
+    void checkpoint(Checkpoint_Stream &stream);
+    void set(unsigned i);
+    void clear(unsigned i);
+    bool isEmpty(void);
+    unsigned first(void);
+};
+class sim_ooo;
+
 class ROB{
 public:
+    sim_ooo *sim;           //simulator owning the ROB
     unsigned currLength;
     unsigned headIndex;
     unsigned tailIndex;
     unsigned num_entries;
     rob_entry_t *entries;
+    unsigned *slot_of_pc;   //ROB entry of each instruction in instruction memory (validated against entry pc)
+    unsigned num_pcs;       //size of slot_of_pc: instructions in instruction memory
 
-    ROB(unsigned mEntries);
+    ROB(unsigned mEntries, sim_ooo *mSim);
+    ROB(const ROB &other, sim_ooo *mSim);
     ~ROB();
     bool push(unsigned mPC);
     bool pop(void);
+    void flush(void);
     rob_entry_t * fetch_head(void);
     bool update_dest_val(unsigned entry, unsigned val);
     bool isFull(void);
@@ -138,6 +326,8 @@ public:
     unsigned get_entry_num(unsigned mPC);
     unsigned get_head_index(void);
     unsigned get_tail_index(void);
+    void map_program(unsigned mInstructions);
+    void checkpoint(Checkpoint_Stream &stream);
 
 };
 class Reservation_Stations{
@@ -146,20 +336,87 @@ class Reservation_Stations{
     unsigned num_load_stations;
     unsigned num_mul_stations;
 public:
+    sim_ooo *sim;                       //simulator owning the stations
     unsigned num_entries;
     res_station_entry_t *entries;
+    Free_List free_stations[MAX_RS];    //available stations of each type
+    Free_List occupied;                 //stations holding an instruction
+
+    //per-station fields scanned on every CDB broadcast, one array each so that the
+    //tag comparison runs over contiguous memory (padded to a multiple of 64 entries)
+    res_station_t *type;                //reservation station type
+    unsigned *value1;                   //Vj field
+    unsigned *value2;                   //Vk field
+    unsigned *tag1;                     //Qj field
+    unsigned *tag2;                     //Qk field
+    long long *CDBWriteDataAvailClkCycle;  //-1 if no operand was written by the CDB
+    unsigned long long *ready;          //scratch bitmask returned by ready_mask()
 
     Reservation_Stations(unsigned  mNum_int_res_stations, unsigned mNum_load_res_stations,
-                         unsigned mNum_add_res_stations, unsigned mNum_mul_res_stations);
+                         unsigned mNum_add_res_stations, unsigned mNum_mul_res_stations, sim_ooo *mSim);
+    Reservation_Stations(const Reservation_Stations &other, sim_ooo *mSim);
     ~Reservation_Stations();
-    res_station_t get_unit_type(opcode_t opcode);
-    bool isReservationStationAvailable(opcode_t opcode);
+    bool isReservationStationAvailable(const instruction_t *instr);
     bool insertEntry(unsigned mPC);
-    res_station_entry_t * fetchReservationStation(opcode_t opcode);
+    res_station_entry_t * fetchReservationStation(const instruction_t *instr);
     void updateTagVal(unsigned tag, unsigned val);
     unsigned get_station_num(unsigned mPC);
+    void release_station(unsigned i);
+    void free_station(unsigned i);
+    void clean(unsigned i);
+    void flush(void);
+    unsigned long long * ready_mask(long long mClkCycle);
+    void checkpoint(Checkpoint_Stream &stream);
 
 };
+//load/store queue: the in-flight loads and stores are indexed by ROB slot, so their age
+//follows the ROB order, and chained in hash buckets by resolved address
+class Load_Store_Queue{
+public:
+    sim_ooo *sim;                   //simulator owning the queue
+    unsigned num_entries;           //one entry per ROB slot
+    unsigned num_buckets;           //power of 2; loads use the first half of buckets, stores the second
+    unsigned *buckets;
+    unsigned *address;              //resolved address of the instruction in the slot
+    unsigned *bucket_of;            //bucket the slot is chained in (UNDEFINED if none)
+    unsigned *next;
+    unsigned *prev;
+    Free_List unresolved_stores;    //stores whose address may not be visible to the loads yet
+    Free_List forwarding_stores;    //stores in WRITE_RESULT, forwarding their data to younger loads
+
+    Load_Store_Queue(unsigned mEntries, sim_ooo *mSim);
+    Load_Store_Queue(const Load_Store_Queue &other, sim_ooo *mSim);
+    ~Load_Store_Queue();
+    void insert_load(unsigned mROBIndex, unsigned mAddr);
+    void insert_store(unsigned mROBIndex, unsigned mAddr);
+    void remove(unsigned mROBIndex);
+    unsigned search_prev_store(unsigned mROBIndex, unsigned mAddr);
+    unsigned load_bucket(unsigned mAddr);
+    unsigned age(unsigned mROBIndex);
+    void flush(void);
+    void checkpoint(Checkpoint_Stream &stream);
+private:
+    void insert(unsigned mBucket, unsigned mROBIndex, unsigned mAddr);
+    void unlink(unsigned mROBIndex);
+};
+//timing wheel of the event-driven core: slot (cycle % num_slots) holds the bitmask of the
+//execution units completing in that clock cycle
+class Timing_Wheel{
+public:
+    unsigned num_slots;     //power of 2 larger than the longest unit latency
+    unsigned *slots;
+    unsigned pending;       //number of units currently scheduled
+
+    Timing_Wheel();
+    ~Timing_Wheel();
+    void resize(unsigned max_latency);
+    void copy(const Timing_Wheel &other);
+    void checkpoint(Checkpoint_Stream &stream);
+    void schedule(unsigned unit, unsigned long long cycle);
+    void cancel(unsigned unit, unsigned long long cycle);
+    void clear(void);
+    unsigned long long next_event(unsigned long long cycle);
+};
 class sim_ooo{
 public:
 	/* Add the data members required by your simulator's implementation here */
@@ -182,31 +439,121 @@ public:
 	//reservation stations
     Reservation_Stations * reservation_stations;
 
+	//load/store queue
+    Load_Store_Queue * lsq;
+
 	//execution units
     unit_t exec_units[MAX_UNITS];
     unsigned num_units;
 
-	//instruction memory
-	instruction_t instr_memory[PROGRAM_SIZE];
+    //address computation units of the loads and stores (one per execution unit)
+    unit_t dummy_units[MAX_UNITS];
+    unsigned num_dummy_units;
+    unsigned curr_dummy_unit;      //next address computation unit to be used
+
+    //clock cycle being simulated
+    unsigned long long current_cycle;
+
+    //available execution units of each type (bit i set if unit i is free)
+    unsigned free_units[NUM_UNIT_TYPES];
+
+    //resources released in the current clock cycle: they become available at the start of the next one
+    release_entry_t *release_queue;
+    unsigned release_count;
+
+    //completion events of the busy execution units
+    Timing_Wheel wheel;
+
+    //event-driven mode: idle clock cycles are skipped up to the next unit completion
+    bool event_driven;
+
+    //unit types whose latency is watched (bit per exe_unit_t): when a unit of one of these types
+    //starts, latency_diverged is set and run() returns at the end of the clock cycle. Used by the
+    //lockstep batches, where one instance simulates configurations differing in these latencies
+    unsigned latency_watch;
+    bool latency_diverged;
+
+    //decoupled mode (see attach_trace): the results of the instructions are read from a functional trace
+    Trace_Ring *trace;                //NULL in the normal mode
+    unsigned trace_consumer;          //consumer index of the simulator in the trace ring
+    trace_record_t *trace_records;    //trace record of the instruction in each ROB entry
+    unsigned trace_wrong_path;        //wrong-path records of the pending taken branch not issued yet
+
+    //run() returns once instructions_executed reaches this count (UNDEFINED_CYCLE: no limit)
+    unsigned long long instruction_limit;
+
+    //set while the pipeline drains (see drain): no instruction is issued
+    bool draining;
+
+    //functional interpreter of the loaded program (see fast_forward), predecoded on first use
+    Interpreter *interpreter;
+
+    //set by the handlers whenever the processor state changes within the current clock cycle
+    bool cycle_progress;
+
+    //target of the mispredicted branch committed in the current clock cycle (UNDEFINED if none):
+    //the younger instructions are squashed at the end of the cycle
+    unsigned redirect_pc;
+
+	//program image loaded by load_program(filename), also when the simulator is reset
+	program_image_t program;
+
+	//program image the instruction memory belongs to ("program" or the image passed to load_program)
+	const program_image_t *loaded_image;
+
+	//instruction memory: the instructions of the program image loaded
+	const instruction_t *instr_memory;
+
+	//number of instructions in instruction memory
+	unsigned instr_memory_size;
 
         //base address in the instruction memory where the program is loaded
         unsigned instr_base_address;
 
-	//data memory - should be initialize to all 0xFF
-	unsigned char *data_memory;
+	//data memory - should be initialize to all 0xFF (paged, see data_memory.h)
+	Data_Memory data_memory;
 
 	//memory size in bytes
 	unsigned data_memory_size;
 	
 	//instruction executed
-	unsigned instructions_executed;
+	unsigned long long instructions_executed;
 
 	//clock cycles
-	unsigned clock_cycles;
+	unsigned long long clock_cycles;
+
+	//CPI stack and stall events (see get_perf_counters)
+	perf_counters_t counters;
+
+	//state of the clock cycle being simulated, attributed to the CPI stack at its end
+	unsigned long long cycle_events[NUM_STALL_EVENTS];  //stall events of the cycle
+	unsigned cycle_event_mask;    //bit e set if cycle_events[e] is not 0
+	bool cycle_commit;            //an instruction committed (or a store started committing)
+	unsigned cycle_stall;         //component blamed for the stall of the oldest instruction held
+	unsigned cycle_stall_age;     //ROB age of that instruction (UNDEFINED if none was held)
+	unsigned cycle_issue_stall;   //component that stopped issue (CPI_BASE if none)
+
+	//a mispredicted branch squashed the pipeline and nothing has committed since
+	bool flushing;
 
 	//execution log
 	stringstream log;
 
+	//binary execution log (see set_log_file): NULL if the log is kept as text in "log"
+	Log_Writer *log_writer;
+
+	//pipeline viewer trace (see set_pipeview_file): NULL if not written
+	Pipeview_Writer *pipeview;
+
+	//per-instruction profile (see enable_profile): NULL if not kept
+	Instruction_Profile *profile;
+
+	//host time spent in the handlers (see host_profile.h): NULL unless built with HOST_PROFILE
+	Host_Profile *host_profile;
+
+	//stream the print functions write to (cout unless set_output is called)
+	ostream *output;
+
 //public:
 
 	/* Instantiates the simulator
@@ -221,9 +568,29 @@ public:
 		unsigned issue_width=1		// issue width
         );	
 	
+	//copies the whole state of a simulator (see clone)
+	sim_ooo(const sim_ooo &other);
+
 	//de-allocates the simulator
 	~sim_ooo();
 
+	//returns an independent copy of the simulator, which can be run from the current clock cycle.
+	//The data memory pages are shared copy-on-write, so a clone costs O(pages touched)
+	sim_ooo *clone();
+
+	//writes the state of the simulator to the checkpoint file "filename" (see checkpoint.h): the
+	//program, the registers, the PC and the data memory and, if "full", the microarchitectural
+	//state too. Without "full" the pipeline must be empty (see drain). A failed write is an error
+	void save_checkpoint(const char *filename, bool full=false);
+
+	//restores the state saved in the checkpoint file "filename". A full checkpoint needs a simulator
+	//configured as the one that saved it, and the run continues from the saved clock cycle, log
+	//included; an architectural one needs an empty pipeline and keeps the cycle count and the log
+	void load_checkpoint(const char *filename);
+
+	//writes or reads the state to or from a checkpoint (see save_checkpoint)
+	void checkpoint(Checkpoint_Stream &stream, bool full);
+
         // adds one or more execution units of a given type to the processor
         // - exec_unit: type of execution unit to be added
         // - latency: latency of the execution unit (in clock cycles)
@@ -232,15 +599,79 @@ public:
 
 
 	//related to functional unit
-	unsigned get_free_unit(opcode_t opcode);
+	unsigned get_free_unit(const instruction_t *instr);
+
+	//marks an execution unit as busy from the current clock cycle and schedules its completion
+	void start_exec_unit(unsigned unit);
+
+	//releases an execution unit and removes its completion event
+	void release_exec_unit(unsigned unit);
+
+	//queues a resource to become available at the start of the next clock cycle
+	void defer_release(release_t kind, unsigned index);
+
+	//makes the resources released in the previous clock cycle available
+	void process_releases();
+
+	//frees every execution unit (used on branch misprediction)
+	void flush_exec_units();
+
+	//squashes the instructions younger than the mispredicted branch and restarts fetching at redirect_pc
+	void squash();
+
+	//selects the event-driven (default) or the cycle-stepped engine; both produce the same log
+	void set_event_driven(bool enable);
+
+	//changes the latency of the execution units of the given type; the busy ones complete
+	//"latency" cycles after they started
+	void set_unit_latency(exe_unit_t exec_unit, unsigned latency);
+
+	//timing-only mode: the simulator reads its instruction stream from the trace ring as consumer
+	//"consumer" and takes the results from it, without computing them nor accessing the data memory
+	//(which is not updated). Must be called before running; the simulator cannot be cloned afterwards
+	void attach_trace(Trace_Ring *ring, unsigned consumer);
+
+	//reads the trace record of the instruction being issued at "pc" into its ROB entry
+	void read_trace(unsigned pc);
 
     void CDB_write(unsigned tag, unsigned val);
 
+	//true if the address is within the loaded program
+	bool isValidPC(unsigned mPC);
+
+	//redirects the output of the print functions
+	void set_output(ostream &os);
+
 	//loads the assembly program in file "filename" in instruction memory at the specified address
 	void load_program(const char *filename, unsigned base_address=0x0);
 
+	//loads an already parsed program: the image is shared, not copied, and must outlive the simulator.
+	//Its data segments are written to data memory
+	void load_program(const program_image_t &image);
+
+	//loads the raw binary file "filename" in data memory at "base_address", reading it through a
+	//memory mapping: the pages left at 0xFF by the image are not allocated (see data_memory.h)
+	void load_memory_image(const char *filename, unsigned base_address=0x0);
+
 	//runs the simulator for "cycles" clock cycles (run the program to completion if cycles=0) 
-	void run(unsigned cycles=0);
+	void run(unsigned long long cycles=0);
+
+	//runs the simulator until "instructions" more instructions have fully executed (or the program
+	//completes); a few more may complete in the last clock cycle
+	void run_instructions(unsigned long long instructions);
+
+	//stops issuing and runs until the instructions in flight have left the pipeline: the registers,
+	//the data memory and the PC are then the architectural state
+	void drain();
+
+	//executes up to "instructions" instructions functionally from the PC, on the registers and the
+	//data memory only (no clock cycle elapses, nothing is logged nor counted as executed). The
+	//pipeline must be empty (see drain). Returns the number of instructions executed
+	unsigned long long fast_forward(unsigned long long instructions);
+
+	//executes up to "instructions" instructions functionally, one at a time, as fast_forward does
+	//without the interpreter (see interpreter.h). Returns the number of instructions executed
+	unsigned long long execute_functional(unsigned long long instructions);
 	
 	//resets the state of the simulator
         /* Note: 
@@ -272,10 +703,24 @@ public:
 	float get_IPC();
 
 	//returns the number of instructions fully executed
-	unsigned get_instructions_executed();
+	unsigned long long get_instructions_executed();
 
 	//returns the number of clock cycles 
-	unsigned get_clock_cycles();
+	unsigned long long get_clock_cycles();
+
+	//returns the CPI stack (the clock cycles attributed to each CPI_* component) and the number
+	//of STALL_* events since the last reset
+	perf_counters_t get_perf_counters();
+
+	//prints the CPI stack and the stall events
+	void print_cpi_stack();
+
+	//attributes the clock cycle just simulated, and the "cycles" - 1 identical ones skipped after
+	//it, to the CPI stack
+	void account_cycles(unsigned long long cycles);
+
+	//counts "n" stall events of the current clock cycle
+	void count_stall(unsigned event, unsigned long long n=1);
 
 	//prints the content of the data memory within the specified address range
 	void print_memory(unsigned start_address, unsigned end_address);
@@ -307,6 +752,28 @@ public:
 	//print log
 	void print_log();
 
+	//from now on, writes the log to the binary file "filename" (see commit_log.h) rather than
+	//keeping it in memory: print_log decodes it back
+	void set_log_file(const char *filename);
+
+	//from now on, also writes every logged instruction, committed or squashed, to the pipeline
+	//viewer trace "filename" (gem5 O3PipeView format, see pipeview.h)
+	void set_pipeview_file(const char *filename);
+
+	//from now on, aggregates every logged instruction into the counters of its static instruction
+	//(see profile.h); the profile is emptied by load_program and reset, and not checkpointed
+	void enable_profile();
+
+	//prints the source of the program loaded, each instruction annotated with its share of the
+	//cycles, its commits and squashes, and the mean and maximum clock cycles from issue to execute,
+	//from execute to write result and from write result to commit
+	void print_profile();
+
 };
 
+inline void sim_ooo::count_stall(unsigned event, unsigned long long n){
+	cycle_events[event] += n;
+	cycle_event_mask |= 1u << event;
+}
+
 #endif /*SIM_OOO_H_*/
@@ -0,0 +1,144 @@
+#ifndef PROGRAMS_H_
+#define PROGRAMS_H_
+
+#include "sim_ooo.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/* Programs of the sequential test cases, for the test cases that check properties of the
+   simulator (checkpoints, clones, logs...) rather than a fixed output: each one is set up with
+   the configuration, registers and data memory of the first test case running it. */
+
+#define NUM_PROGRAMS 6
+
+static const char *const program_files[NUM_PROGRAMS] = {"asm/code_ooo.asm", "asm/code_ooo2.asm", "asm/code_ooo3.asm",
+						  "asm/code_ooo4.asm", "asm/code_ooo5.asm", "asm/sort.asm"};
+
+//instantiates the simulator of program p (testcases 1, 4, 6, 7, 8 and 9)
+inline sim_ooo *new_program_sim(unsigned p){
+	switch(p){
+		case 0: {
+			sim_ooo *sim = new sim_ooo(1024*1024, 6, 1, 2, 2, 2);
+			sim->init_exec_unit(INTEGER, 2, 1);
+			sim->init_exec_unit(ADDER, 2, 2);
+			sim->init_exec_unit(MULTIPLIER, 10, 1);
+			sim->init_exec_unit(DIVIDER, 40, 1);
+			sim->init_exec_unit(MEMORY, 1, 1);
+			return sim;
+		}
+		case 1: {
+			sim_ooo *sim = new sim_ooo(1024*1024, 6, 2, 2, 2, 1);
+			sim->init_exec_unit(INTEGER, 2, 1);
+			sim->init_exec_unit(ADDER, 2, 2);
+			sim->init_exec_unit(MULTIPLIER, 10, 1);
+			sim->init_exec_unit(DIVIDER, 40, 1);
+			sim->init_exec_unit(MEMORY, 1, 1);
+			return sim;
+		}
+		case 2: {
+			sim_ooo *sim = new sim_ooo(1024*1024, 6, 2, 2, 2, 2);
+			sim->init_exec_unit(INTEGER, 2, 1);
+			sim->init_exec_unit(ADDER, 3, 2);
+			sim->init_exec_unit(MULTIPLIER, 10, 1);
+			sim->init_exec_unit(DIVIDER, 40, 1);
+			sim->init_exec_unit(MEMORY, 5, 1);
+			return sim;
+		}
+		case 3:
+		case 4: {
+			sim_ooo *sim = new sim_ooo(1024*1024, 6, 1, 2, 2, 3);
+			sim->init_exec_unit(INTEGER, 2, 1);
+			sim->init_exec_unit(ADDER, 3, 1);
+			sim->init_exec_unit(MULTIPLIER, 10, 1);
+			sim->init_exec_unit(DIVIDER, 40, 1);
+			sim->init_exec_unit(MEMORY, 5, 1);
+			return sim;
+		}
+		default: {
+			sim_ooo *sim = new sim_ooo(1024*1024, 6, 3, 2, 2, 2, 2);
+			sim->init_exec_unit(INTEGER, 3, 2);
+			sim->init_exec_unit(ADDER, 3, 2);
+			sim->init_exec_unit(MULTIPLIER, 10, 1);
+			sim->init_exec_unit(DIVIDER, 40, 1);
+			sim->init_exec_unit(MEMORY, 5, 1);
+			return sim;
+		}
+	}
+}
+
+//initializes the registers and the data memory program p reads, in a simulator or in a functional
+//executor (see functional.h)
+template <typename T> void init_program_state(T *sim, unsigned p){
+	unsigned i, j;
+	switch(p){
+		case 0:
+			sim->set_int_register(1, 10);
+			sim->set_int_register(2, 20);
+			sim->set_int_register(3, 10);
+			for (i=0; i<11; i++) sim->set_fp_register(i, (float)i*10.0);
+			sim->write_memory(0x14, float2bits(10.0));
+			sim->write_memory(0x28, float2bits(30.0));
+			break;
+		case 1:
+			for (i=0; i<5; i++) sim->set_fp_register(i, (float)i);
+			for (i = 0xA000, j=0; i<0xA020; i+=4, j+=1) sim->write_memory(i, float2bits((float)(j+1)));
+			break;
+		case 2:
+			sim->set_int_register(0, 0);
+			sim->set_int_register(2, 6);
+			sim->set_int_register(3, 0xA000);
+			for (i=1; i<5; i++) sim->set_fp_register(i, 0.0);
+			for (i = 0xA000, j=0; i<0xA020; i+=4, j+=1) sim->write_memory(i, float2bits((float)(j)));
+			break;
+		case 3:
+			sim->set_int_register(1, 0xA000);
+			sim->set_int_register(2, 0xA004);
+			sim->set_int_register(3, 0xA004);
+			for (i = 0xA000, j=1; i<0xA020; i+=4, j+=1) sim->write_memory(i, float2bits((float)(j)));
+			break;
+		case 4:
+			sim->set_int_register(1, 0xA000);
+			sim->set_int_register(2, 0xA004);
+			sim->set_fp_register(1, 100.0);
+			for (i = 0xA000, j=1; i<0xA020; i+=4, j+=1) sim->write_memory(i, float2bits((float)(j)));
+			break;
+		default: {
+			float values[12] = {15.5, 3.1, 23.0, 1.3, 4.4, 12.6, 0.0, -12.1, 30.2, 44.7, 41.5, -10.3};
+			sim->set_int_register(7, 0x80000000);
+			for (i=0; i<12; i++) sim->write_memory(0xA000 + 4*i, float2bits(values[i]));
+			break;
+		}
+	}
+}
+
+//loads program p and initializes the registers and the data memory it reads
+inline void load_program_state(sim_ooo *sim, unsigned p){
+	sim->load_program(program_files[p], 0x00000000);
+	init_program_state(sim, p);
+}
+
+//returns the simulator of program p, ready to run
+inline sim_ooo *setup_program(unsigned p){
+	sim_ooo *sim = new_program_sim(p);
+	load_program_state(sim, p);
+	return sim;
+}
+
+//returns what a run left: log, registers, data memory read by the programs, and counters
+inline string final_state(sim_ooo *sim){
+	ostringstream out;
+	sim->set_output(out);
+	sim->print_log();
+	sim->print_registers();
+	sim->print_memory(0x0, 0x30);
+	sim->print_memory(0xA000, 0xA030);
+	sim->print_memory(0xB000, 0xB030);
+	out << sim->get_instructions_executed() << " " << sim->get_clock_cycles() << endl;
+	sim->set_output(cout);
+	return out.str();
+}
+
+#endif /*PROGRAMS_H_*/
@@ -0,0 +1,144 @@
+#include "sim_ooo.h"
+#include "commit_log.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+/* Test case for the binary execution log (see commit_log.h):
+   - the ten test cases run with their log written to a binary file (set_log_file), and the
+     output of each one, where print_log decodes that file, must match the output of the
+     sequential run (testcases/testcaseN.out) byte for byte;
+   - log entries whose cycles are too far apart for a 32-bit record (LOG_WIDE records, only
+     reached by runs of billions of clock cycles) are written and decoded back */
+
+namespace binary_log {
+	//output of the test case running
+	ostringstream cout;
+
+	//binary log file of the simulators
+	char filename[] = "/tmp/testcase_binary_logXXXXXX";
+
+	//simulator writing its log to the binary log file
+	class sim_ooo : public ::sim_ooo{
+	public:
+		sim_ooo(unsigned mem_size, unsigned rob_size, unsigned num_int_res_stations, unsigned num_add_res_stations,
+			unsigned num_mul_res_stations, unsigned num_load_buffers, unsigned issue_width=1) :
+			::sim_ooo(mem_size, rob_size, num_int_res_stations, num_add_res_stations, num_mul_res_stations, num_load_buffers, issue_width){
+			set_output(cout);
+			set_log_file(filename);
+		}
+	};
+}
+
+//each test case is compiled in its own namespace, with its main turned into "void run(int argc, char **argv)"
+//(the test cases do not return any value from main)
+#define TESTCASE(n) namespace testcase##n { using binary_log::cout; using binary_log::sim_ooo;
+#define main(...) unused_main(); void run(__VA_ARGS__)
+
+TESTCASE(1)
+#include "testcase1.cc"
+}
+TESTCASE(2)
+#include "testcase2.cc"
+}
+TESTCASE(3)
+#include "testcase3.cc"
+}
+TESTCASE(4)
+#include "testcase4.cc"
+}
+TESTCASE(5)
+#include "testcase5.cc"
+}
+TESTCASE(6)
+#include "testcase6.cc"
+}
+TESTCASE(7)
+#include "testcase7.cc"
+}
+TESTCASE(8)
+#include "testcase8.cc"
+}
+TESTCASE(9)
+#include "testcase9.cc"
+}
+TESTCASE(10)
+#include "testcase10.cc"
+}
+
+#undef main
+
+#define NUM_TESTCASES 10
+
+typedef void (*testcase_t)(int, char **);
+
+static testcase_t testcases[NUM_TESTCASES] = {testcase1::run, testcase2::run, testcase3::run, testcase4::run, testcase5::run,
+					      testcase6::run, testcase7::run, testcase8::run, testcase9::run, testcase10::run};
+
+#define NUM_WIDE_ENTRIES 6
+
+#define WIDE (1ULL << 32)
+
+//log entries with cycle distances around and above 32 bits
+static instr_window_entry_t wide_entries[NUM_WIDE_ENTRIES] = {
+	{0x00000000, 1, 2, 4, 5},
+	{0x00000004, 3 * WIDE + 7, 3 * WIDE + 9, 3 * WIDE + 19, 3 * WIDE + 20},             //issued 3 * 2^32 cycles later
+	{0x00000008, 3 * WIDE + 8, 4 * WIDE + 8, 5 * WIDE, 6 * WIDE + 1},                    //stages 2^32 cycles apart
+	{0x0000000c, 3 * WIDE + 8, 3 * WIDE + UNDEFINED - 1, UNDEFINED_CYCLE, UNDEFINED_CYCLE}, //squashed, just below a wide distance
+	{0x00000010, 3 * WIDE + 9, 3 * WIDE + 10, 3 * WIDE + 12, 3 * WIDE + 13},
+	{UNDEFINED, UNDEFINED_CYCLE, UNDEFINED_CYCLE, UNDEFINED_CYCLE, UNDEFINED_CYCLE}
+};
+
+int main(int argc, char **argv){
+
+	int fd = mkstemp(binary_log::filename);
+	if (fd < 0){
+		cerr << "error: open file " << binary_log::filename << " failed!" << endl;
+		exit(-1);
+	}
+	close(fd);
+
+	//runs the test cases one after the other, each one on the same binary log file
+	unsigned failed = 0;
+	for (unsigned i=0; i<NUM_TESTCASES; i++){
+		binary_log::cout.str("");
+		testcases[i](0, NULL);
+
+		stringstream filename;
+		filename << "testcases/testcase" << i+1 << ".out";
+		ifstream fin(filename.str().c_str(), ios::in | ios::binary);
+		if (!fin.is_open()) {
+			cerr << "error: open file " << filename.str() << " failed!" << endl;
+			exit(-1);
+		}
+		stringstream expected;
+		expected << fin.rdbuf();
+		bool same = (expected.str() == binary_log::cout.str());
+		std::cout << "testcase" << i+1 << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+
+	//wide entries, written and decoded without a simulator
+	ostringstream expected;
+	print_log_header(expected);
+	Log_Writer *writer = new Log_Writer(binary_log::filename);
+	for (unsigned e=0; e<NUM_WIDE_ENTRIES; e++){
+		writer->append(wide_entries[e]);
+		print_log_entry(expected, wide_entries[e]);
+	}
+	delete writer;
+	ifstream fin(binary_log::filename, ios::in | ios::binary);
+	ostringstream decoded;
+	bool same = decode_log(fin, decoded) && (decoded.str() == expected.str());
+	std::cout << "wide entries: " << (same ? "PASS" : "FAIL") << endl;
+	if (!same) failed++;
+
+	remove(binary_log::filename);
+
+	return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "programs.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* Test case for the checkpoints: for each program of the sequential test cases
+   - a full checkpoint is saved at every clock cycle and restored into a new simulator, which must
+     run to the same log, registers, data memory and counters as the uninterrupted run;
+   - an architectural checkpoint is saved after draining the pipeline every few instructions and
+     restored into a new simulator, which must execute the rest of the program to the same
+     registers and data memory as the simulator that saved it */
+
+//instructions between two architectural checkpoints
+#define ARCH_INTERVAL 5
+
+//registers and data memory read by the programs
+static string architectural_state(sim_ooo *sim){
+	ostringstream out;
+	sim->set_output(out);
+	sim->print_registers();
+	sim->print_memory(0x0, 0x30);
+	sim->print_memory(0xA000, 0xA030);
+	sim->print_memory(0xB000, 0xB030);
+	sim->set_output(cout);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	char filename[] = "/tmp/testcase_checkpointXXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	close(fd);
+
+	unsigned failed = 0;
+	for (unsigned p=0; p<NUM_PROGRAMS; p++){
+		sim_ooo *sim = setup_program(p);
+		sim->run();
+		string expected = final_state(sim);
+		unsigned long long cycles = sim->get_clock_cycles();
+		unsigned long long instructions = sim->get_instructions_executed();
+		delete sim;
+
+		//full checkpoints, restored into a simulator without a program
+		unsigned full = 0, full_same = 0;
+		for (unsigned long long cycle=1; cycle<cycles; cycle++){
+			sim = setup_program(p);
+			sim->run(cycle);
+			sim->save_checkpoint(filename, true);
+			delete sim;
+			sim = new_program_sim(p);
+			sim->load_checkpoint(filename);
+			sim->run();
+			if (final_state(sim) == expected) full_same++;
+			full++;
+			delete sim;
+		}
+
+		//architectural checkpoints, the rest of the program executed functionally
+		unsigned arch = 0, arch_same = 0;
+		for (unsigned long long executed=ARCH_INTERVAL; executed<instructions; executed+=ARCH_INTERVAL){
+			sim = setup_program(p);
+			sim->run_instructions(executed);
+			sim->drain();
+			sim->save_checkpoint(filename);
+			sim_ooo *restored = new_program_sim(p);
+			restored->load_checkpoint(filename);
+			sim->fast_forward(instructions);
+			restored->fast_forward(instructions);
+			if (architectural_state(restored) == architectural_state(sim)) arch_same++;
+			arch++;
+			delete sim;
+			delete restored;
+		}
+
+		bool same = (full_same == full) && (arch_same == arch);
+		cout << program_files[p] << ": full " << full_same << "/" << full << ", architectural " << arch_same << "/" << arch
+		     << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+	remove(filename);
+
+	return (failed == 0) ? 0 : 1;
+}
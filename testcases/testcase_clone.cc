@@ -0,0 +1,59 @@
+#include "programs.h"
+#include <stdlib.h>
+#include <vector>
+
+using namespace std;
+
+/* Test case for the clones (see sim_ooo::clone): for each program of the sequential test cases,
+   the simulator is cloned at every clock cycle and
+   - the clone must run to the same log, registers, data memory and counters as the uninterrupted
+     run, and so must the original afterwards;
+   - while the clone runs to completion, and after it writes every word of the data memory the
+     programs use, the contents of the original's data memory, whose pages the clone shares,
+     must not change */
+
+//words of the data memory, read one by one (a copy of the memory would share its pages)
+static vector<unsigned> memory_words(sim_ooo *sim){
+	vector<unsigned> words(sim->data_memory.size / 4);
+	for (unsigned i=0; i<words.size(); i++) words[i] = sim->data_memory.load_word(4*i);
+	return words;
+}
+
+int main(int argc, char **argv){
+
+	unsigned failed = 0;
+	for (unsigned p=0; p<NUM_PROGRAMS; p++){
+		sim_ooo *sim = setup_program(p);
+		sim->run();
+		string expected = final_state(sim);
+		unsigned long long cycles = sim->get_clock_cycles();
+		delete sim;
+
+		unsigned clones = 0, same_runs = 0, isolated = 0;
+		for (unsigned long long cycle=1; cycle<cycles; cycle++){
+			sim = setup_program(p);
+			sim->run(cycle);
+			sim_ooo *copy = sim->clone();
+			vector<unsigned> words = memory_words(sim);
+
+			copy->run();
+			bool copy_same = (final_state(copy) == expected);
+			for (unsigned address=0; address<0xB030; address+=4) copy->write_memory(address, ~address);
+			bool unchanged = (memory_words(sim) == words);
+			delete copy;
+
+			sim->run();
+			if (copy_same && final_state(sim) == expected) same_runs++;
+			if (unchanged) isolated++;
+			clones++;
+			delete sim;
+		}
+
+		bool same = (same_runs == clones) && (isolated == clones);
+		cout << program_files[p] << ": same runs " << same_runs << "/" << clones << ", memory unchanged " << isolated << "/" << clones
+		     << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+
+	return (failed == 0) ? 0 : 1;
+}
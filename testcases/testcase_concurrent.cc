@@ -0,0 +1,106 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+/* Test case for the reentrancy of the simulator: the ten test cases run at the same
+   time, each one on its own thread and simulator instance, and the output of each one
+   must match the output of the sequential run (testcases/testcaseN.out) byte for byte */
+
+namespace concurrent {
+	//output of the test case running on the current thread
+	thread_local ostringstream cout;
+
+	//simulator printing to the output of the thread that instantiates it
+	class sim_ooo : public ::sim_ooo{
+	public:
+		sim_ooo(unsigned mem_size, unsigned rob_size, unsigned num_int_res_stations, unsigned num_add_res_stations,
+			unsigned num_mul_res_stations, unsigned num_load_buffers, unsigned issue_width=1) :
+			::sim_ooo(mem_size, rob_size, num_int_res_stations, num_add_res_stations, num_mul_res_stations, num_load_buffers, issue_width){
+			set_output(cout);
+		}
+	};
+}
+
+//each test case is compiled in its own namespace, with its main turned into "void run(int argc, char **argv)"
+//(the test cases do not return any value from main)
+#define TESTCASE(n) namespace testcase##n { using concurrent::cout; using concurrent::sim_ooo;
+#define main(...) unused_main(); void run(__VA_ARGS__)
+
+TESTCASE(1)
+#include "testcase1.cc"
+}
+TESTCASE(2)
+#include "testcase2.cc"
+}
+TESTCASE(3)
+#include "testcase3.cc"
+}
+TESTCASE(4)
+#include "testcase4.cc"
+}
+TESTCASE(5)
+#include "testcase5.cc"
+}
+TESTCASE(6)
+#include "testcase6.cc"
+}
+TESTCASE(7)
+#include "testcase7.cc"
+}
+TESTCASE(8)
+#include "testcase8.cc"
+}
+TESTCASE(9)
+#include "testcase9.cc"
+}
+TESTCASE(10)
+#include "testcase10.cc"
+}
+
+#undef main
+
+#define NUM_TESTCASES 10
+
+typedef void (*testcase_t)(int, char **);
+
+static testcase_t testcases[NUM_TESTCASES] = {testcase1::run, testcase2::run, testcase3::run, testcase4::run, testcase5::run,
+					      testcase6::run, testcase7::run, testcase8::run, testcase9::run, testcase10::run};
+
+int main(int argc, char **argv){
+
+	string outputs[NUM_TESTCASES];
+	thread threads[NUM_TESTCASES];
+
+	//runs all the test cases at the same time
+	for (unsigned i=0; i<NUM_TESTCASES; i++){
+		threads[i] = thread([i, &outputs](){
+			testcases[i](0, NULL);
+			outputs[i] = concurrent::cout.str();
+		});
+	}
+	for (unsigned i=0; i<NUM_TESTCASES; i++) threads[i].join();
+
+	//compares each output with the one of the sequential run
+	unsigned failed = 0;
+	for (unsigned i=0; i<NUM_TESTCASES; i++){
+		stringstream filename;
+		filename << "testcases/testcase" << i+1 << ".out";
+		ifstream fin(filename.str().c_str(), ios::in | ios::binary);
+		if (!fin.is_open()) {
+			cerr << "error: open file " << filename.str() << " failed!" << endl;
+			exit(-1);
+		}
+		stringstream expected;
+		expected << fin.rdbuf();
+		bool same = (expected.str() == outputs[i]);
+		std::cout << "testcase" << i+1 << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+
+	return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "programs.h"
+#include <stdlib.h>
+
+using namespace std;
+
+/* Test case for the CPI stack (see print_cpi_stack): every clock cycle is attributed to exactly
+   one component, so once a program completes the components must sum to get_clock_cycles(), and
+   while it runs to the clock cycles simulated so far. This is checked for the programs of the
+   sequential test cases, stopped at every clock cycle and then run to completion, with the
+   event-driven engine (which attributes the cycles it skips in bulk) and the cycle-stepped one,
+   and at the stops of run_instructions and drain */
+
+//sum of the components of the CPI stack
+static unsigned long long stack_cycles(sim_ooo *sim){
+	perf_counters_t counters = sim->get_perf_counters();
+	unsigned long long total = 0;
+	for (unsigned c=0; c<NUM_CPI_COMPONENTS; c++) total += counters.cycles[c];
+	return total;
+}
+
+//true if the CPI stack of the simulator accounts for all its clock cycles (get_clock_cycles()
+//is only set when the program completes)
+static bool cycles_accounted(sim_ooo *sim, bool completed){
+	return stack_cycles(sim) == (completed ? sim->get_clock_cycles() : sim->current_cycle);
+}
+
+int main(int argc, char **argv){
+
+	unsigned failed = 0;
+	for (unsigned p=0; p<NUM_PROGRAMS; p++){
+		unsigned checks = 0, accounted = 0;
+		for (unsigned event_driven=0; event_driven<2; event_driven++){
+			//stopped at each clock cycle, then run to completion
+			sim_ooo *sim = setup_program(p);
+			sim->set_event_driven(event_driven);
+			sim->run();
+			unsigned long long cycles = sim->get_clock_cycles();
+			delete sim;
+			for (unsigned long long cycle=1; cycle<cycles; cycle++){
+				sim = setup_program(p);
+				sim->set_event_driven(event_driven);
+				sim->run(cycle);
+				if (cycles_accounted(sim, false)) accounted++;
+				sim->run();
+				if (cycles_accounted(sim, true)) accounted++;
+				checks += 2;
+				delete sim;
+			}
+
+			//a few instructions at a time, drained, then run to completion
+			sim = setup_program(p);
+			sim->set_event_driven(event_driven);
+			for (unsigned i=0; i<10; i++){
+				sim->run_instructions(3);
+				if (cycles_accounted(sim, false)) accounted++;
+				checks++;
+			}
+			sim->drain();
+			if (cycles_accounted(sim, false)) accounted++;
+			sim->run();
+			if (cycles_accounted(sim, true)) accounted++;
+			checks += 2;
+			delete sim;
+		}
+
+		bool same = (accounted == checks);
+		cout << program_files[p] << ": cycles accounted " << accounted << "/" << checks << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+
+	return (failed == 0) ? 0 : 1;
+}
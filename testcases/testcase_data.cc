@@ -0,0 +1,106 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/* Test case for the initial content of the data memory:
+   - asm/data.asm places data with each directive (.data, .word, .float, .space), which must be
+     in the data memory once the program is loaded, and then computes on it;
+   - memory images (see load_memory_image) are loaded at an aligned and at an unaligned address,
+     and their pages left at 0xFF must not be allocated */
+
+static unsigned failed = 0;
+
+//checks a word of the data memory
+static void check_word(sim_ooo *sim, unsigned address, unsigned expected, const char *what){
+	unsigned value = sim->data_memory.load_word(address);
+	if (value != expected){
+		cout << what << " at 0x" << hex << address << ": 0x" << value << ", expected 0x" << expected << dec << ": FAIL" << endl;
+		failed++;
+	}
+}
+
+//writes a memory image file
+static void write_image(const char *filename, const vector<unsigned char> &bytes){
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL || fwrite(&bytes[0], 1, bytes.size(), file) != bytes.size() || fclose(file) != 0){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+}
+
+int main(int argc, char **argv){
+
+	sim_ooo *sim = new sim_ooo(1024*1024, 6, 1, 2, 2, 2);
+	sim->init_exec_unit(INTEGER, 2, 1);
+	sim->init_exec_unit(ADDER, 2, 2);
+	sim->init_exec_unit(MULTIPLIER, 10, 1);
+	sim->init_exec_unit(DIVIDER, 40, 1);
+	sim->init_exec_unit(MEMORY, 1, 1);
+
+	//data directives
+	sim->load_program("asm/data.asm", 0x00000000);
+	check_word(sim, 0xA000, 1, ".word");
+	check_word(sim, 0xA004, (unsigned)-2, ".word");
+	check_word(sim, 0xA008, 0x10, ".word");
+	check_word(sim, 0xA00C, 8, ".word");
+	check_word(sim, 0xA010, float2bits(1.5), ".float");
+	check_word(sim, 0xA014, float2bits(-0.25), ".float");
+	check_word(sim, 0xA018, 0xFFFFFFFF, ".space");
+	check_word(sim, 0xA01C, 0xFFFFFFFF, ".space");
+	check_word(sim, 0xA020, 0x7FFFFFFF, ".word");
+	check_word(sim, 0xA024, 0xFFFFFFFF, "end of the data");
+	check_word(sim, 0xC000, float2bits(2.0), ".data");
+	sim->run();
+	check_word(sim, 0xB000, 17, "program result");
+	check_word(sim, 0xB004, float2bits(3.0), "program result");
+	cout << "asm/data.asm: " << (failed == 0 ? "PASS" : "FAIL") << endl;
+	unsigned failed_before = failed;
+
+	//memory images: two pages with data around a page of 0xFF
+	char filename[] = "/tmp/testcase_dataXXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0){
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	close(fd);
+	vector<unsigned char> bytes(3 * MEMORY_PAGE_SIZE + 100, 0xFF);
+	for (unsigned i=0; i<MEMORY_PAGE_SIZE; i++) bytes[i] = i % 251;
+	for (unsigned i=2 * MEMORY_PAGE_SIZE; i<bytes.size(); i++) bytes[i] = i % 13;
+	write_image(filename, bytes);
+
+	unsigned base = 0x20000;
+	sim->load_memory_image(filename, base);
+	for (unsigned i=0; i<bytes.size(); i++){
+		if (sim->data_memory.load_byte(base + i) != bytes[i]){
+			cout << "image byte 0x" << hex << base + i << dec << ": FAIL" << endl;
+			failed++;
+			break;
+		}
+	}
+	if (sim->data_memory.read_page((base >> MEMORY_PAGE_BITS) + 1) != NULL){
+		cout << "image page of 0xFF allocated: FAIL" << endl;
+		failed++;
+	}
+
+	//unaligned: the bytes around the image keep their value
+	base = 0x30001;
+	bytes.resize(10);
+	write_image(filename, bytes);
+	sim->load_memory_image(filename, base);
+	check_word(sim, 0x30000, 0x020100FF, "unaligned image");
+	check_word(sim, 0x30004, 0x06050403, "unaligned image");
+	check_word(sim, 0x30008, 0xFF090807, "unaligned image");
+	remove(filename);
+	cout << "memory images: " << (failed == failed_before ? "PASS" : "FAIL") << endl;
+
+	delete sim;
+
+	return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include "programs.h"
+#include "functional.h"
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* Test case for the functional-first decoupled mode (see functional.h): each program of the
+   sequential test cases runs once on a functional executor, whose trace feeds, on concurrent
+   threads, timing-only simulators over a range of configurations (ROB sizes, issue widths, unit
+   latencies). Each one must produce the same log, registers and counters as the stepped
+   simulator with the same configuration. */
+
+#define NUM_ROB_SIZES 4
+#define NUM_LATENCY_SETS 2
+#define NUM_CONFIGS (NUM_ROB_SIZES * 2 * NUM_LATENCY_SETS)
+
+static const unsigned rob_sizes[NUM_ROB_SIZES] = {2, 4, 6, 9};
+
+//latencies of the integer, adder, multiplier, divider and memory units
+static const unsigned latency_sets[NUM_LATENCY_SETS][NUM_UNIT_TYPES] = {{1, 2, 10, 40, 1}, {3, 4, 6, 12, 5}};
+
+//instantiates the simulator of a configuration
+static sim_ooo *new_config_sim(unsigned config){
+	unsigned rob_size = rob_sizes[config % NUM_ROB_SIZES];
+	unsigned issue_width = 1 + (config / NUM_ROB_SIZES) % 2;
+	const unsigned *latencies = latency_sets[config / (NUM_ROB_SIZES * 2)];
+	sim_ooo *sim = new sim_ooo(1024*1024, rob_size, 2, 2, 2, 2, issue_width);
+	sim->init_exec_unit(INTEGER, latencies[INTEGER], 2);
+	sim->init_exec_unit(ADDER, latencies[ADDER], 2);
+	sim->init_exec_unit(MULTIPLIER, latencies[MULTIPLIER], 1);
+	sim->init_exec_unit(DIVIDER, latencies[DIVIDER], 1);
+	sim->init_exec_unit(MEMORY, latencies[MEMORY], 1);
+	return sim;
+}
+
+//what a timing-only run leaves: its data memory is not updated
+static string timing_state(sim_ooo *sim){
+	ostringstream out;
+	sim->set_output(out);
+	sim->print_log();
+	sim->print_registers();
+	out << sim->get_instructions_executed() << " " << sim->get_clock_cycles() << endl;
+	sim->set_output(cout);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	unsigned failed = 0;
+	for (unsigned p=0; p<NUM_PROGRAMS; p++){
+		program_image_t image;
+		parse_program(program_files[p], 0x00000000, &image);
+
+		//stepped runs
+		string expected[NUM_CONFIGS];
+		for (unsigned c=0; c<NUM_CONFIGS; c++){
+			sim_ooo *sim = new_config_sim(c);
+			sim->load_program(image);
+			init_program_state(sim, p);
+			sim->run();
+			expected[c] = timing_state(sim);
+			delete sim;
+		}
+
+		//one functional execution, all the configurations reading its trace
+		unsigned window = 0;
+		for (unsigned r=0; r<NUM_ROB_SIZES; r++) window = max(window, rob_sizes[r] - 1);
+		Trace_Ring ring(window, NUM_CONFIGS);
+		Functional_Executor executor(1024*1024);
+		executor.load_program(image);
+		init_program_state(&executor, p);
+
+		string states[NUM_CONFIGS];
+		vector<thread> threads;
+		threads.push_back(thread([&](){
+			executor.run(&ring);
+		}));
+		for (unsigned c=0; c<NUM_CONFIGS; c++){
+			threads.push_back(thread([&, c](){
+				sim_ooo *sim = new_config_sim(c);
+				sim->load_program(image);
+				init_program_state(sim, p);
+				sim->attach_trace(&ring, c);
+				sim->run();
+				states[c] = timing_state(sim);
+				delete sim;
+				ring.detach(c);
+			}));
+		}
+		for (unsigned t=0; t<threads.size(); t++) threads[t].join();
+
+		unsigned same_runs = 0;
+		for (unsigned c=0; c<NUM_CONFIGS; c++) if (states[c] == expected[c]) same_runs++;
+		bool same = (same_runs == NUM_CONFIGS);
+		cout << program_files[p] << ": same runs " << same_runs << "/" << NUM_CONFIGS << ": " << (same ? "PASS" : "FAIL") << endl;
+		if (!same) failed++;
+	}
+
+	return (failed == 0) ? 0 : 1;
+}
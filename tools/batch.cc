@@ -0,0 +1,199 @@
+#include "job.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+/* Batch job runner.
+   Runs the simulation jobs listed in a manifest in a single process: every distinct assembly
+   file is parsed once into a program image shared by all the jobs that run it, and the jobs
+   run on a work-stealing thread pool. One CSV record is written per job as soon as it completes
+   (the job column gives its position in the manifest).
+
+   With -f the jobs run in the functional-first decoupled mode (see functional.h): the jobs that
+   share the program, the memory size and the initial state read the instruction stream of one
+   functional execution of the program, up to one job per thread at a time, and only simulate
+   the timing of the pipeline.
+
+   usage: batch <manifest> [-j threads] [-o output file] [-f]
+
+   Manifest, one job per line ('#' starts a comment):
+     <program> <setting>*
+   where each setting is one of
+     <parameter>=<value>   processor parameter (see param_names in job.cc, default: the
+                           processor of testcase1)
+     memory=<bytes>        size of the data memory (default 1MB)
+     budget=<cycles>       cycles after which the job is abandoned (default 1000000, 0 = none)
+     name=<name>           name of the job in the output (default: the program)
+     Rn=int Fn=float address=value
+                           initial state of the registers and memory (a value containing
+                           a '.' is stored as a float) */
+
+typedef struct{
+	string name;
+	job_t job;
+	init_t init;
+	string state; //program, memory size and initialization: jobs with the same state can share a trace
+} entry_t;
+
+static void parse_manifest(const char *filename, vector<entry_t> &entries, Program_Cache &cache){
+	ifstream fin(filename);
+	if (!fin.is_open()) fail(string("open file ") + filename + " failed!");
+
+	string text;
+	unsigned line_nr = 0;
+	while (getline(fin, text)){
+		line_nr++;
+		text = text.substr(0, text.find('#'));
+		stringstream line(text);
+		string program;
+		if (!(line >> program)) continue;
+
+		stringstream where;
+		where << filename << ":" << line_nr << ": ";
+		entry_t entry;
+		entry.name = program;
+		entry.job.program = cache.get(program);
+		for (unsigned p=0; p<NUM_PARAMS; p++) entry.job.params[p] = param_defaults[p];
+		entry.job.memory_size = 1024*1024;
+		entry.job.budget = 1000000;
+		stringstream state;
+		state << program << " " << entry.job.memory_size;
+
+		string token;
+		while (line >> token){
+			size_t eq = token.find('=');
+			string key = token.substr(0, eq);
+			string value = (eq == string::npos) ? "" : token.substr(eq+1);
+			unsigned p = find_param(key);
+			if (p != NUM_PARAMS) entry.job.params[p] = parse_unsigned(value);
+			else if (key == "memory") entry.job.memory_size = parse_unsigned(value);
+			else if (key == "budget") entry.job.budget = parse_count(value);
+			else if (key == "name") entry.name = value;
+			else if (parse_init(token, &entry.init)) state << " " << token;
+			else fail(where.str() + "invalid setting " + token);
+		}
+		if (entry.job.memory_size != 1024*1024) state << " memory=" << entry.job.memory_size;
+		entry.state = state.str();
+		if (!valid_params(entry.job.params)) fail(where.str() + "invalid processor configuration");
+		if (!valid_init(&entry.init, entry.job.memory_size)) fail(where.str() + "initialization out of range");
+		entries.push_back(entry);
+	}
+	//the init is referenced once the entries do not move anymore
+	for (unsigned i=0; i<entries.size(); i++) entries[i].job.init = &entries[i].init;
+}
+
+//runs the jobs in decoupled mode, at most "width" timing simulators per functional execution
+static void run_decoupled(const vector<entry_t> &entries, unsigned width, const function<void(unsigned, const result_t &)> &report){
+	map<string, vector<unsigned> > groups;
+	for (unsigned j=0; j<entries.size(); j++) groups[entries[j].state].push_back(j);
+
+	//the functional executions run one at a time, so they share an executor: its memory is reset
+	//(the pages written kept allocated) rather than allocated again, unless the size changes
+	Functional_Executor *executor = NULL;
+
+	for (map<string, vector<unsigned> >::iterator it = groups.begin(); it != groups.end(); it++){
+		const vector<unsigned> &group = it->second;
+		for (unsigned first=0; first<group.size(); first+=width){
+			vector<unsigned> jobs(group.begin() + first, group.begin() + min((unsigned)group.size(), first + width));
+			unsigned window = 0;
+			for (unsigned c=0; c<jobs.size(); c++) window = max(window, entries[jobs[c]].job.params[PARAM_ROB] - 1);
+			Trace_Ring ring(window, jobs.size());
+			const job_t &functional_job = entries[jobs[0]].job;
+			if (executor != NULL && executor->data_memory_size == functional_job.memory_size){
+				executor->reset();
+				init_functional_executor(executor, functional_job);
+			} else {
+				delete executor;
+				executor = new_functional_executor(functional_job);
+			}
+
+			//one thread runs the program, one per job simulates its timing
+			vector<thread> threads;
+			threads.push_back(thread([&](){
+				executor->run(&ring);
+			}));
+			for (unsigned c=0; c<jobs.size(); c++){
+				threads.push_back(thread([&, c](){
+					const job_t &job = entries[jobs[c]].job;
+					ostream discard(NULL);
+					sim_ooo *sim = new_simulator(job, discard);
+					sim->attach_trace(&ring, c);
+					sim->run(job.budget);
+					result_t result = get_result(sim);
+					delete sim;
+					ring.detach(c);
+					report(jobs[c], result);
+				}));
+			}
+			for (unsigned t=0; t<threads.size(); t++) threads[t].join();
+		}
+	}
+	delete executor;
+}
+
+int main(int argc, char **argv){
+
+	const char *manifest = NULL;
+	const char *output_file = NULL;
+	unsigned num_threads = 0;
+	bool decoupled = false;
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i], "-j") && i+1<argc) num_threads = parse_unsigned(argv[++i]);
+		else if (!strcmp(argv[i], "-f")) decoupled = true;
+		else if (!strcmp(argv[i], "-o") && i+1<argc) output_file = argv[++i];
+		else if (manifest == NULL) manifest = argv[i];
+		else fail(string("unexpected argument ") + argv[i]);
+	}
+	if (manifest == NULL){
+		cerr << "usage: " << argv[0] << " <manifest> [-j threads] [-o output file] [-f]" << endl;
+		return -1;
+	}
+
+	Program_Cache cache;
+	vector<entry_t> entries;
+	parse_manifest(manifest, entries, cache);
+
+	ofstream fout;
+	if (output_file != NULL){
+		fout.open(output_file);
+		if (!fout.is_open()) fail(string("open file ") + output_file + " failed!");
+	}
+	ostream &out = (output_file != NULL) ? fout : cout;
+	out << "job,name,cycles,instructions,ipc" << endl;
+
+	Thread_Pool pool(num_threads);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	//the records are written as the jobs complete
+	mutex out_lock;
+	function<void(unsigned, const result_t &)> report = [&](unsigned j, const result_t &result){
+		stringstream record;
+		record << j << "," << entries[j].name << ",";
+		if (result.cycles == TIMEOUT) record << "timeout," << result.instructions << ",0";
+		else record << result.cycles << "," << result.instructions << "," << (float)result.instructions/result.cycles;
+		lock_guard<mutex> guard(out_lock);
+		out << record.str() << endl;
+	};
+	if (decoupled){
+		run_decoupled(entries, pool.size(), report);
+	} else {
+		pool.run(entries.size(), [&](unsigned j){
+			report(j, simulate(entries[j].job));
+		});
+	}
+
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cerr << entries.size() << " jobs (" << cache.size() << " programs parsed) on " << pool.size()
+	     << " threads in " << elapsed << "s" << endl;
+
+	return 0;
+}
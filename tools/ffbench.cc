@@ -0,0 +1,107 @@
+#include "job.h"
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+using namespace std;
+
+/* Functional execution benchmark.
+   Runs the same program, from the same initial state, on each engine of the simulator and
+   prints the host speed of each in millions of simulated instructions per second (MIPS):
+     interpreter    sim_ooo::fast_forward (predecoded basic blocks, threaded dispatch)
+     step           sim_ooo::execute_functional (one instruction at a time)
+     pipeline       sim_ooo::run_instructions (the detailed timing model)
+   Every engine runs up to "instructions" instructions (the pipeline up to "detailed"), and the
+   two functional ones must end in the same state.
+
+   usage: ffbench <program> <setting>* [-n instructions] [-d detailed] [-r repetitions]
+
+   where each setting is one of
+     <parameter>=<value>   processor parameter (see param_names in job.cc, default: the
+                           processor of testcase1)
+     memory=<bytes>        size of the data memory (default 1MB)
+     Rn=int Fn=float address=value
+                           initial state of the registers and memory (a value containing
+                           a '.' is stored as a float)
+   and the options are
+     -n  instructions run functionally (default 100000000, 0 = the whole program)
+     -d  instructions run on the pipeline (default 1000000, 0 = none)
+     -r  runs of each engine, the fastest is reported (default 3) */
+
+//state of the registers, of the PC and of the data memory, to compare two runs
+static bool same_state(sim_ooo *a, sim_ooo *b){
+	for (unsigned i=0; i<NUM_GP_REGISTERS; i++){
+		if (a->int_reg_file[i].val != b->int_reg_file[i].val) return false;
+		if (a->fp_reg_file[i].val != b->fp_reg_file[i].val) return false;
+	}
+	return a->PC == b->PC && a->data_memory.equal(b->data_memory);
+}
+
+//prints the speed of an engine
+static void report(const char *engine, unsigned long long instructions, double seconds){
+	cout << left << setw(14) << engine << right << setw(14) << instructions << setw(12) << fixed << setprecision(3) << seconds
+	     << setw(12) << setprecision(2) << (seconds > 0 ? instructions / seconds / 1e6 : 0) << endl;
+}
+
+int main(int argc, char **argv){
+
+	const char *program = NULL;
+	job_t job;
+	init_t init;
+	for (unsigned p=0; p<NUM_PARAMS; p++) job.params[p] = param_defaults[p];
+	job.memory_size = 1024*1024;
+	job.budget = 0;
+	unsigned long long instructions = 100000000;
+	unsigned long long detailed = 1000000;
+	unsigned repetitions = 3;
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i], "-n") && i+1<argc) instructions = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-d") && i+1<argc) detailed = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i+1<argc) repetitions = parse_unsigned(argv[++i]);
+		else if (program == NULL && strchr(argv[i], '=') == NULL) program = argv[i];
+		else if (!parse_setting(argv[i], &job, &init)) fail(string("unexpected argument ") + argv[i]);
+	}
+	if (program == NULL){
+		cerr << "usage: " << argv[0] << " <program> <setting>* [-n instructions] [-d detailed] [-r repetitions]" << endl;
+		return -1;
+	}
+	if (repetitions == 0) fail("at least one run is needed");
+	if (!valid_params(job.params)) fail("invalid processor configuration");
+	if (!valid_init(&init, job.memory_size)) fail("initialization out of range");
+	if (instructions == 0) instructions = UNDEFINED_CYCLE;
+
+	Program_Cache cache;
+	job.program = cache.get(program);
+	job.init = &init;
+	ostream discard(NULL);
+
+	cout << left << setw(14) << "engine" << right << setw(14) << "instructions" << setw(12) << "seconds" << setw(12) << "MIPS" << endl;
+	sim_ooo *reference = NULL;
+	for (unsigned engine=0; engine<3; engine++){
+		if (engine == 2 && detailed == 0) break;
+		double best = 0;
+		unsigned long long executed = 0;
+		for (unsigned r=0; r<repetitions; r++){
+			sim_ooo *sim = new_simulator(job, discard);
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			if (engine == 0) executed = sim->fast_forward(instructions);
+			else if (engine == 1) executed = sim->execute_functional(instructions);
+			else{
+				sim->run_instructions(detailed);
+				executed = sim->get_instructions_executed();
+			}
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			if (r == 0 || seconds < best) best = seconds;
+			if (engine == 0 && reference == NULL) reference = sim;
+			else{
+				if (engine == 1 && !same_state(reference, sim)) fail("the interpreter and the step engine disagree");
+				delete sim;
+			}
+		}
+		report(engine == 0 ? "interpreter" : (engine == 1 ? "step" : "pipeline"), executed, best);
+	}
+	delete reference;
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "job.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+
+const char *param_names[NUM_PARAMS] = {"rob", "int_rs", "add_rs", "mul_rs", "load_rs", "issue",
+				       "int_lat", "int_n", "add_lat", "add_n", "mul_lat", "mul_n",
+				       "div_lat", "div_n", "mem_lat", "mem_n"};
+
+const unsigned param_defaults[NUM_PARAMS] = {6, 1, 2, 2, 2, 1, 2, 1, 2, 2, 10, 1, 40, 1, 1, 1};
+
+void fail(const string &msg){
+	cerr << "error: " << msg << endl;
+	exit(-1);
+}
+
+unsigned parse_unsigned(const string &token){
+	return (unsigned)parse_count(token);
+}
+
+unsigned long long parse_count(const string &token){
+	char *end;
+	unsigned long long value = strtoull(token.c_str(), &end, 0);
+	if (token.empty() || *end != '\0') fail("invalid number " + token);
+	return value;
+}
+
+unsigned find_param(const string &name){
+	unsigned p = 0;
+	while (p<NUM_PARAMS && name != param_names[p]) p++;
+	return p;
+}
+
+bool parse_init(const string &token, init_t *init){
+	size_t eq = token.find('=');
+	if (eq == string::npos || eq == 0) return false;
+	string target = token.substr(0, eq);
+	string value = token.substr(eq+1);
+	if (target[0] == 'R'){
+		init->int_registers.push_back(make_pair(parse_unsigned(target.substr(1)), (int)strtoul(value.c_str(), NULL, 0)));
+	} else if (target[0] == 'F'){
+		init->fp_registers.push_back(make_pair(parse_unsigned(target.substr(1)), strtof(value.c_str(), NULL)));
+	} else if (target[0] >= '0' && target[0] <= '9'){
+		unsigned word;
+		if (value.find('.') != string::npos){
+			float f = strtof(value.c_str(), NULL);
+			memcpy(&word, &f, sizeof word);
+		} else {
+			word = (unsigned)strtoul(value.c_str(), NULL, 0);
+		}
+		init->memory.push_back(make_pair(parse_unsigned(target), word));
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_setting(const string &token, job_t *job, init_t *init){
+	size_t eq = token.find('=');
+	if (eq == string::npos) return false;
+	string key = token.substr(0, eq);
+	unsigned p = find_param(key);
+	if (p != NUM_PARAMS) job->params[p] = parse_unsigned(token.substr(eq+1));
+	else if (key == "memory") job->memory_size = parse_unsigned(token.substr(eq+1));
+	else return parse_init(token, init);
+	return true;
+}
+
+bool valid_params(const unsigned *params){
+	unsigned units = 0;
+	for (unsigned p=0; p<NUM_PARAMS; p++) if (params[p] == 0) return false;
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++) units += params[PARAM_INST(u)];
+	return units <= MAX_UNITS;
+}
+
+bool valid_init(const init_t *init, unsigned memory_size){
+	for (unsigned i=0; i<init->int_registers.size(); i++) if (init->int_registers[i].first >= NUM_GP_REGISTERS) return false;
+	for (unsigned i=0; i<init->fp_registers.size(); i++) if (init->fp_registers[i].first >= NUM_GP_REGISTERS) return false;
+	for (unsigned i=0; i<init->memory.size(); i++) if (memory_size < 4 || init->memory[i].first > memory_size - 4) return false;
+	return true;
+}
+
+sim_ooo *new_simulator(const job_t &job, ostream &output){
+	const unsigned *params = job.params;
+	sim_ooo *sim = new sim_ooo(job.memory_size, params[PARAM_ROB], params[PARAM_INT_RS], params[PARAM_ADD_RS], params[PARAM_MUL_RS],
+				   params[PARAM_LOAD_RS], params[PARAM_ISSUE]);
+	sim->set_output(output);
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++) sim->init_exec_unit((exe_unit_t)u, params[PARAM_LAT(u)], params[PARAM_INST(u)]);
+	sim->load_program(*job.program);
+	const init_t *init = job.init;
+	for (unsigned i=0; i<init->int_registers.size(); i++) sim->set_int_register(init->int_registers[i].first, init->int_registers[i].second);
+	for (unsigned i=0; i<init->fp_registers.size(); i++) sim->set_fp_register(init->fp_registers[i].first, init->fp_registers[i].second);
+	for (unsigned i=0; i<init->memory.size(); i++) sim->write_memory(init->memory[i].first, init->memory[i].second);
+	return sim;
+}
+
+Functional_Executor *new_functional_executor(const job_t &job){
+	Functional_Executor *executor = new Functional_Executor(job.memory_size);
+	init_functional_executor(executor, job);
+	return executor;
+}
+
+void init_functional_executor(Functional_Executor *executor, const job_t &job){
+	executor->load_program(*job.program);
+	const init_t *init = job.init;
+	for (unsigned i=0; i<init->int_registers.size(); i++) executor->set_int_register(init->int_registers[i].first, init->int_registers[i].second);
+	for (unsigned i=0; i<init->fp_registers.size(); i++) executor->set_fp_register(init->fp_registers[i].first, init->fp_registers[i].second);
+	for (unsigned i=0; i<init->memory.size(); i++) executor->write_memory(init->memory[i].first, init->memory[i].second);
+}
+
+result_t get_result(sim_ooo *sim){
+	result_t result;
+	result.cycles = (sim->get_clock_cycles() == 0) ? TIMEOUT : sim->get_clock_cycles();
+	result.instructions = sim->get_instructions_executed();
+	return result;
+}
+
+result_t simulate(const job_t &job){
+	ostream discard(NULL);
+	sim_ooo *sim = new_simulator(job, discard);
+	sim->run(job.budget);
+	result_t result = get_result(sim);
+	delete sim;
+	return result;
+}
+
+Program_Cache::~Program_Cache(){
+	for (map<string, program_image_t *>::iterator it = images.begin(); it != images.end(); it++) delete it->second;
+}
+
+const program_image_t *Program_Cache::get(const string &filename){
+	lock_guard<mutex> guard(lock);
+	map<string, program_image_t *>::iterator search = images.find(filename);
+	if (search != images.end()) return search->second;
+	ifstream fin(filename.c_str());
+	if (!fin.is_open()) fail("open file " + filename + " failed!");
+	program_image_t *image = new program_image_t;
+	parse_program(filename.c_str(), 0x00000000, image);
+	images[filename] = image;
+	return image;
+}
+
+unsigned Program_Cache::size(){
+	lock_guard<mutex> guard(lock);
+	return images.size();
+}
@@ -0,0 +1,111 @@
+#ifndef JOB_H_
+#define JOB_H_
+
+#include "sim_ooo.h"
+#include "functional.h"
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+/* Simulation jobs shared by the tools: processor configuration, initial state of the
+   registers and of the data memory, parsed program cache and job execution. */
+
+//parameters of a processor configuration: the constructor ones, then latency and instances of each unit type
+#define PARAM_ROB		0
+#define PARAM_INT_RS		1
+#define PARAM_ADD_RS		2
+#define PARAM_MUL_RS		3
+#define PARAM_LOAD_RS		4
+#define PARAM_ISSUE		5
+#define PARAM_LAT(unit)		(6 + 2*(unit))
+#define PARAM_INST(unit)	(7 + 2*(unit))
+#define NUM_PARAMS		(6 + 2*NUM_UNIT_TYPES)
+
+//name of each parameter in the tools input files
+extern const char *param_names[NUM_PARAMS];
+
+//default value of each parameter: the processor of testcase1
+extern const unsigned param_defaults[NUM_PARAMS];
+
+//cycles of a job that did not complete within its budget
+#define TIMEOUT UNDEFINED_CYCLE
+
+//initial state of the registers and of the data memory
+typedef struct{
+	vector<pair<unsigned, int> > int_registers;
+	vector<pair<unsigned, float> > fp_registers;
+	vector<pair<unsigned, unsigned> > memory;
+} init_t;
+
+//one simulation
+typedef struct{
+	const program_image_t *program;
+	const init_t *init;
+	unsigned params[NUM_PARAMS];
+	unsigned memory_size; //size of the data memory (in byte)
+	unsigned long long budget; //cycles after which the simulation is abandoned (0 = none)
+} job_t;
+
+//outcome of a simulation
+typedef struct{
+	unsigned long long cycles; //TIMEOUT if the program did not complete within the budget
+	unsigned long long instructions;
+} result_t;
+
+//prints the error message and exits
+void fail(const string &msg);
+
+//parses a decimal, hexadecimal (0x) or octal (0) number
+unsigned parse_unsigned(const string &token);
+
+//parses a 64-bit count (clock cycles or instructions), in the same formats
+unsigned long long parse_count(const string &token);
+
+//returns the index of the named parameter (NUM_PARAMS if there is none)
+unsigned find_param(const string &name);
+
+//parses an initialization: Rn=int, Fn=float or address=value, where a value containing a '.'
+//is stored as a float (returns false if the token is not an initialization)
+bool parse_init(const string &token, init_t *init);
+
+//parses a setting of a job given on the command line: <parameter>=<value>, memory=<bytes> or an
+//initialization (returns false if the token is none of them)
+bool parse_setting(const string &token, job_t *job, init_t *init);
+
+//checks that a configuration fits in the simulator and that the initialization fits in its memory
+bool valid_params(const unsigned *params);
+bool valid_init(const init_t *init, unsigned memory_size);
+
+//returns a simulator with the configuration, program and initial state of the job, printing to "output"
+sim_ooo *new_simulator(const job_t &job, ostream &output);
+
+//returns a functional executor with the program and initial state of the job
+Functional_Executor *new_functional_executor(const job_t &job);
+
+//loads the program and initial state of the job in a functional executor that has been reset
+void init_functional_executor(Functional_Executor *executor, const job_t &job);
+
+//returns the outcome of a simulator that has run
+result_t get_result(sim_ooo *sim);
+
+//runs a job on a new simulator instance
+result_t simulate(const job_t &job);
+
+/* Parsed program cache: every assembly file is parsed once, and all the jobs running it share
+   the same image. Images are never modified or evicted, so they can be used without locking. */
+class Program_Cache{
+	mutex lock;
+	map<string, program_image_t *> images;
+
+public:
+	~Program_Cache();
+
+	//returns the image of the program in file "filename" at address 0, parsing it on first use
+	const program_image_t *get(const string &filename);
+
+	//number of programs parsed
+	unsigned size();
+};
+
+#endif /*JOB_H_*/
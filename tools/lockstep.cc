@@ -0,0 +1,88 @@
+#include "lockstep.h"
+#include <iostream>
+
+vector<unsigned> lockstep_key(const unsigned *params){
+	vector<unsigned> key(params, params + NUM_PARAMS);
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++) key[PARAM_LAT(u)] = (params[PARAM_LAT(u)] == 1) ? 1 : 0;
+	return key;
+}
+
+//unit types whose latency differs among the given lanes
+static unsigned divergent_units(const vector<const unsigned *> &lanes, const vector<unsigned> &group){
+	unsigned mask = 0;
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++)
+		for (unsigned i=1; i<group.size(); i++)
+			if (lanes[group[i]][PARAM_LAT(u)] != lanes[group[0]][PARAM_LAT(u)]) mask |= (1u << u);
+	return mask;
+}
+
+//true if two lanes have the same latency for all the unit types in "mask"
+static bool same_latencies(const unsigned *a, const unsigned *b, unsigned mask){
+	for (unsigned u=0; u<NUM_UNIT_TYPES; u++)
+		if ((mask & (1u << u)) && (a[PARAM_LAT(u)] != b[PARAM_LAT(u)])) return false;
+	return true;
+}
+
+void simulate_lockstep(const job_t &job, const vector<const unsigned *> &lanes, vector<result_t> &results){
+	results.assign(lanes.size(), result_t());
+	if (lanes.empty()) return;
+
+	//a simulator instance and the lanes it is simulating
+	typedef struct{
+		sim_ooo *sim;
+		vector<unsigned> group;
+	} branch_t;
+
+	ostream discard(NULL);
+	job_t first = job;
+	for (unsigned p=0; p<NUM_PARAMS; p++) first.params[p] = lanes[0][p];
+	branch_t root;
+	root.sim = new_simulator(first, discard);
+	for (unsigned i=0; i<lanes.size(); i++) root.group.push_back(i);
+
+	vector<branch_t> branches(1, root);
+	while (!branches.empty()){
+		branch_t branch = branches.back();
+		branches.pop_back();
+		sim_ooo *sim = branch.sim;
+
+		while (true){
+			sim->latency_watch = divergent_units(lanes, branch.group);
+			sim->latency_diverged = false;
+			if ((job.budget == 0) || (sim->current_cycle < job.budget)) sim->run((job.budget == 0) ? 0 : job.budget - sim->current_cycle);
+			if (!sim->latency_diverged) break;
+
+			//the latency of the units started in this clock cycle decides which lanes stay together
+			unsigned started = 0;
+			for (unsigned u=0; u<sim->num_units; u++)
+				if (sim->exec_units[u].pc != UNDEFINED) started |= (1u << sim->exec_units[u].type);
+			started &= sim->latency_watch;
+
+			vector<vector<unsigned> > partitions;
+			for (unsigned i=0; i<branch.group.size(); i++){
+				unsigned lane = branch.group[i];
+				unsigned p = 0;
+				while (p<partitions.size() && !same_latencies(lanes[partitions[p][0]], lanes[lane], started)) p++;
+				if (p == partitions.size()) partitions.push_back(vector<unsigned>());
+				partitions[p].push_back(lane);
+			}
+
+			//copies first, as the latencies of this instance are changed by its own partition
+			for (unsigned p=1; p<partitions.size(); p++){
+				branch_t split;
+				split.sim = sim->clone();
+				split.group = partitions[p];
+				for (unsigned u=0; u<NUM_UNIT_TYPES; u++)
+					if (started & (1u << u)) split.sim->set_unit_latency((exe_unit_t)u, lanes[partitions[p][0]][PARAM_LAT(u)]);
+				branches.push_back(split);
+			}
+			branch.group = partitions[0];
+			for (unsigned u=0; u<NUM_UNIT_TYPES; u++)
+				if (started & (1u << u)) sim->set_unit_latency((exe_unit_t)u, lanes[partitions[0][0]][PARAM_LAT(u)]);
+		}
+
+		result_t result = get_result(sim);
+		for (unsigned i=0; i<branch.group.size(); i++) results[branch.group[i]] = result;
+		delete sim;
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef LOCKSTEP_H_
+#define LOCKSTEP_H_
+
+#include "job.h"
+
+/* Lockstep batches: one program run on many configurations (lanes) that differ only in the
+   latency of their execution units. All the lanes share one simulator instance as long as they
+   take the same pipeline decisions, that is until a unit whose latency differs among them
+   starts. At the end of that clock cycle the instance is cloned, and each copy continues with
+   the lanes that agree on the latencies of the units just started, after moving their
+   completion cycle. Lanes whose control flow never reaches a unit type do not pay for
+   its latency.
+
+   A unit with a latency of 1 completes in the clock cycle in which it starts, before the
+   lanes can be split, so lanes only share an instance when they agree on which unit types
+   have a latency of 1 (see lockstep_key).
+
+   Only the latencies may diverge: the number of units and of reservation stations, the widths
+   and every other parameter are part of the lockstep key, so configurations that differ in
+   any of them never share an instance and are run one instance per batch. */
+
+//returns the lockstep key of a configuration: lanes can be run in the same batch if their keys are equal
+vector<unsigned> lockstep_key(const unsigned *params);
+
+//runs the job on each configuration in "lanes" (all with the same lockstep key); job.params is ignored
+void simulate_lockstep(const job_t &job, const vector<const unsigned *> &lanes, vector<result_t> &results);
+
+#endif /*LOCKSTEP_H_*/
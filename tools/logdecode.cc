@@ -0,0 +1,28 @@
+#include "commit_log.h"
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+/* Binary execution log decoder.
+   Prints the text execution log (as print_log does) of a binary log written by a simulator
+   after sim_ooo::set_log_file.
+
+   usage: logdecode <binary log> */
+
+int main(int argc, char **argv){
+	if (argc != 2){
+		cerr << "usage: " << argv[0] << " <binary log>" << endl;
+		return -1;
+	}
+	ifstream fin(argv[1], ios::in | ios::binary);
+	if (!fin.is_open()){
+		cerr << "error: open file " << argv[1] << " failed!" << endl;
+		return -1;
+	}
+	if (!decode_log(fin, cout)){
+		cerr << "error: " << argv[1] << " is not a binary execution log" << endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,148 @@
+#include "job.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+using namespace std;
+
+/* Sampled simulation (SMARTS).
+   Estimates the CPI of a program without simulating all of it in detail. The program is cut
+   into periods of k*U instructions; in each period the simulator fast-forwards functionally
+   (registers and data memory only, see sim_ooo::fast_forward), then simulates W instructions
+   in detail to fill the pipeline (warm-up) and U more instructions whose CPI is the sample, and
+   finally drains the pipeline. The CPI of the program is the mean of the samples, given with
+   its confidence interval; sampling stops at the end of the program, or as soon as at least
+   "min samples" samples bring the relative error of the estimate under the target.
+
+   usage: sample <program> <setting>* [-u unit] [-w warm-up] [-k period] [-e error]
+                 [-c confidence] [-n min samples]
+
+   where each setting is one of
+     <parameter>=<value>   processor parameter (see param_names in job.cc, default: the
+                           processor of testcase1)
+     memory=<bytes>        size of the data memory (default 1MB)
+     Rn=int Fn=float address=value
+                           initial state of the registers and memory (a value containing
+                           a '.' is stored as a float)
+   and the options are
+     -u  instructions per sample (default 1000)
+     -w  warm-up instructions before each sample (default 2000)
+     -k  sampling period, in samples (default 100: one sample every 100*U instructions)
+     -e  target relative error of the CPI (default 0.03)
+     -c  confidence level of the interval (default 0.997)
+     -n  samples taken before the error is checked (default 30) */
+
+//returns z such that a standard normal variable lies in [-z, z] with probability "confidence"
+static double z_score(double confidence){
+	double low = 0, high = 10;
+	for (unsigned i=0; i<100; i++){
+		double z = (low + high) / 2;
+		if (erf(z / sqrt(2.0)) < confidence) low = z;
+		else high = z;
+	}
+	return (low + high) / 2;
+}
+
+int main(int argc, char **argv){
+
+	const char *program = NULL;
+	job_t job;
+	init_t init;
+	for (unsigned p=0; p<NUM_PARAMS; p++) job.params[p] = param_defaults[p];
+	job.memory_size = 1024*1024;
+	job.budget = 0;
+	unsigned long long unit = 1000;
+	unsigned long long warmup = 2000;
+	unsigned long long period = 100;
+	double target = 0.03;
+	double confidence = 0.997;
+	unsigned min_samples = 30;
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i], "-u") && i+1<argc) unit = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-w") && i+1<argc) warmup = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-k") && i+1<argc) period = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-e") && i+1<argc) target = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-c") && i+1<argc) confidence = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-n") && i+1<argc) min_samples = parse_unsigned(argv[++i]);
+		else if (program == NULL && strchr(argv[i], '=') == NULL) program = argv[i];
+		else if (!parse_setting(argv[i], &job, &init)) fail(string("unexpected argument ") + argv[i]);
+	}
+	if (program == NULL){
+		cerr << "usage: " << argv[0] << " <program> <setting>* [-u unit] [-w warm-up] [-k period] [-e error] [-c confidence] [-n min samples]" << endl;
+		return -1;
+	}
+	if (unit == 0 || period == 0 || period * unit < unit + warmup) fail("the sampling period must hold the warm-up and the sample");
+	if (confidence <= 0 || confidence >= 1) fail("the confidence level must be in (0, 1)");
+	if (!valid_params(job.params)) fail("invalid processor configuration");
+	if (!valid_init(&init, job.memory_size)) fail("initialization out of range");
+
+	Program_Cache cache;
+	job.program = cache.get(program);
+	job.init = &init;
+	ostream discard(NULL);
+	sim_ooo *sim = new_simulator(job, discard);
+
+	double z = z_score(confidence);
+	unsigned long long fast_forwarded = 0;
+	unsigned long long samples = 0;
+	double sum = 0, sum_squares = 0;
+	double mean = 0, half_width = 0;
+	bool converged = false;
+	while (true){
+		//fast-forward to the warm-up of the next sample
+		unsigned long long skip = period * unit - warmup - unit;
+		unsigned long long skipped = sim->fast_forward(skip);
+		fast_forwarded += skipped;
+		if (skipped < skip) break;
+
+		unsigned long long start = sim->get_instructions_executed();
+		sim->run_instructions(warmup);
+		if (sim->get_instructions_executed() - start < warmup) break;
+
+		unsigned long long first_cycle = sim->current_cycle;
+		unsigned long long first_instruction = sim->get_instructions_executed();
+		sim->run_instructions(unit);
+		unsigned long long instructions = sim->get_instructions_executed() - first_instruction;
+		if (instructions < unit) break;
+		double cpi = (double)(sim->current_cycle - first_cycle) / instructions;
+		sim->drain();
+		//the execution log of the detailed windows is not needed
+		sim->log.str("");
+
+		samples++;
+		sum += cpi;
+		sum_squares += cpi * cpi;
+		mean = sum / samples;
+		if (samples > 1){
+			double variance = (sum_squares - samples * mean * mean) / (samples - 1);
+			half_width = z * sqrt(variance > 0 ? variance : 0) / sqrt((double)samples);
+		}
+		if (samples >= min_samples && half_width <= target * mean){
+			converged = true;
+			break;
+		}
+	}
+	unsigned long long detailed = sim->get_instructions_executed();
+	delete sim;
+
+	cout << "program        " << program << endl;
+	cout << "instructions   " << fast_forwarded + detailed << " (" << detailed << " in detail)"
+	     << (converged ? ", stopped at the target error" : ", program completed") << endl;
+	cout << "samples        " << samples << " of " << unit << " instructions, every " << period * unit
+	     << " instructions, after " << warmup << " of warm-up" << endl;
+	if (samples < 2){
+		cout << "too few samples for an estimate: reduce the sampling period" << endl;
+		return 0;
+	}
+	cout << fixed << setprecision(4);
+	cout << "CPI            " << mean << " +- " << half_width << " (" << setprecision(1) << confidence * 100
+	     << "% confidence, relative error " << half_width / mean * 100 << "%)" << endl;
+	cout << setprecision(4);
+	cout << "IPC            " << 1 / mean << " [" << 1 / (mean + half_width) << ", ";
+	if (half_width < mean) cout << 1 / (mean - half_width) << "]" << endl;
+	else cout << "inf]" << endl;
+	return 0;
+}
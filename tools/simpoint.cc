@@ -0,0 +1,353 @@
+#include "job.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <random>
+
+using namespace std;
+
+/* Phase analysis and simulation of representative intervals (SimPoint).
+   The program first runs functionally (see sim_ooo::fast_forward), one basic block at a time,
+   and the instructions executed in each basic block are counted over intervals of about
+   "interval" instructions (an interval ends with the first block that completes it): these
+   basic block vectors (BBVs), normalized and randomly projected to PROJECTED_DIMS dimensions,
+   are clustered with k-means for k = 1..max clusters. The clustering kept is the one with the
+   fewest clusters whose Bayesian Information Criterion score is within 90% of the best one.
+   The interval closest to the centre of each cluster represents it.
+
+   The program then runs functionally again, and the simulator is cloned (a checkpoint) "warm-up"
+   instructions before each representative interval. The checkpoints are simulated in detail
+   concurrently: the warm-up fills the pipeline, then the interval gives the CPI of its cluster.
+   The CPI of the program is the mean of the cluster CPIs weighted by the instructions of their
+   intervals.
+
+   usage: simpoint <program> <setting>* [-i interval] [-k max clusters] [-w warm-up] [-j threads]
+
+   where each setting is one of
+     <parameter>=<value>   processor parameter (see param_names in job.cc, default: the
+                           processor of testcase1)
+     memory=<bytes>        size of the data memory (default 1MB)
+     Rn=int Fn=float address=value
+                           initial state of the registers and memory (a value containing
+                           a '.' is stored as a float)
+   and the options are
+     -i  instructions per interval (default 100000)
+     -k  largest number of clusters tried (default 10)
+     -w  warm-up instructions before each representative interval (default 10000)
+     -j  threads simulating the intervals (default: one per hardware thread) */
+
+//dimensions of the projected basic block vectors
+#define PROJECTED_DIMS 15
+
+//k-means runs (from different initial centres) per number of clusters; the best is kept
+#define KMEANS_SEEDS 5
+
+//k-means iterations (at most)
+#define KMEANS_ITERATIONS 100
+
+typedef vector<double> point_t;
+
+//clustering of the intervals
+typedef struct{
+	unsigned k;
+	vector<point_t> centres;
+	vector<unsigned> cluster;  //cluster of each interval
+	double distortion;         //sum of the squared distances of the intervals from their centres
+	double bic;
+} clustering_t;
+
+static double distance2(const point_t &a, const point_t &b){
+	double d = 0;
+	for (unsigned i=0; i<a.size(); i++) d += (a[i] - b[i]) * (a[i] - b[i]);
+	return d;
+}
+
+//basic blocks of a program: an instruction starts a block if it is the first one, a branch
+//target or follows a branch. Returns the block of each instruction and the end (index of the
+//instruction following it) of each block
+static unsigned find_basic_blocks(const program_image_t &image, vector<unsigned> &block_of, vector<unsigned> &block_end){
+	unsigned size = image.instructions.size();
+	vector<bool> leader(size, false);
+	leader[0] = true;
+	for (unsigned i=0; i<size; i++){
+		const instruction_t &instr = image.instructions[i];
+		if (!(instr.flags & INSTR_BRANCH)) continue;
+		if (i+1 < size) leader[i+1] = true;
+		unsigned target = (instr.target - image.base_address) / 4;
+		if (instr.target >= image.base_address && target < size) leader[target] = true;
+	}
+	block_of.assign(size, 0);
+	block_end.clear();
+	for (unsigned i=0; i<size; i++){
+		if (leader[i]) block_end.push_back(i);
+		block_of[i] = block_end.size() - 1;
+		block_end.back()++;
+	}
+	return block_end.size();
+}
+
+//assigns the points to their nearest centre; returns true if an assignment changed
+static bool assign(const vector<point_t> &points, clustering_t &c){
+	bool changed = false;
+	c.distortion = 0;
+	for (unsigned p=0; p<points.size(); p++){
+		unsigned best = 0;
+		double best_distance = distance2(points[p], c.centres[0]);
+		for (unsigned j=1; j<c.k; j++){
+			double d = distance2(points[p], c.centres[j]);
+			if (d < best_distance){
+				best = j;
+				best_distance = d;
+			}
+		}
+		if (c.cluster[p] != best) changed = true;
+		c.cluster[p] = best;
+		c.distortion += best_distance;
+	}
+	return changed;
+}
+
+//k-means with k-means++ initial centres
+static clustering_t kmeans(const vector<point_t> &points, unsigned k, mt19937 &random){
+	clustering_t c;
+	c.k = k;
+	c.cluster.assign(points.size(), k);
+	c.centres.push_back(points[random() % points.size()]);
+	vector<double> nearest(points.size());
+	while (c.centres.size() < k){
+		double total = 0;
+		for (unsigned p=0; p<points.size(); p++){
+			nearest[p] = distance2(points[p], c.centres[0]);
+			for (unsigned j=1; j<c.centres.size(); j++) nearest[p] = min(nearest[p], distance2(points[p], c.centres[j]));
+			total += nearest[p];
+		}
+		//a point is chosen with probability proportional to its squared distance from the centres
+		double r = uniform_real_distribution<double>(0, total)(random);
+		unsigned p = 0;
+		while (p+1 < points.size() && r >= nearest[p]){
+			r -= nearest[p];
+			p++;
+		}
+		c.centres.push_back(points[p]);
+	}
+	for (unsigned it=0; it<KMEANS_ITERATIONS && assign(points, c); it++){
+		vector<unsigned> count(k, 0);
+		for (unsigned j=0; j<k; j++) c.centres[j].assign(points[0].size(), 0);
+		for (unsigned p=0; p<points.size(); p++){
+			count[c.cluster[p]]++;
+			for (unsigned d=0; d<points[p].size(); d++) c.centres[c.cluster[p]][d] += points[p][d];
+		}
+		for (unsigned j=0; j<k; j++){
+			//an empty cluster keeps the point farthest from its centre
+			if (count[j] == 0){
+				unsigned far = 0;
+				for (unsigned p=1; p<points.size(); p++)
+					if (distance2(points[p], c.centres[c.cluster[p]]) > distance2(points[far], c.centres[c.cluster[far]])) far = p;
+				c.centres[j] = points[far];
+				continue;
+			}
+			for (unsigned d=0; d<c.centres[j].size(); d++) c.centres[j][d] /= count[j];
+		}
+	}
+	return c;
+}
+
+//Bayesian Information Criterion of a clustering, for spherical Gaussian clusters (as in X-means)
+static double bic(const vector<point_t> &points, const clustering_t &c){
+	double R = points.size();
+	double M = points[0].size();
+	double K = c.k;
+	double variance = (R > K) ? c.distortion / (R - K) : 0;
+	if (variance <= 0) variance = 1e-12;
+	vector<unsigned> size(c.k, 0);
+	for (unsigned p=0; p<points.size(); p++) size[c.cluster[p]]++;
+	double likelihood = 0;
+	for (unsigned j=0; j<c.k; j++){
+		double n = size[j];
+		if (n == 0) continue;
+		likelihood += n * log(n) - n * log(R) - n / 2 * log(2 * M_PI) - n * M / 2 * log(variance) - (n - K) / 2;
+	}
+	double parameters = (K - 1) + M * K + 1;
+	return likelihood - parameters / 2 * log(R);
+}
+
+int main(int argc, char **argv){
+
+	const char *program = NULL;
+	job_t job;
+	init_t init;
+	for (unsigned p=0; p<NUM_PARAMS; p++) job.params[p] = param_defaults[p];
+	job.memory_size = 1024*1024;
+	job.budget = 0;
+	unsigned long long interval = 100000;
+	unsigned max_clusters = 10;
+	unsigned long long warmup = 10000;
+	unsigned num_threads = 0;
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i], "-i") && i+1<argc) interval = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-k") && i+1<argc) max_clusters = parse_unsigned(argv[++i]);
+		else if (!strcmp(argv[i], "-w") && i+1<argc) warmup = parse_count(argv[++i]);
+		else if (!strcmp(argv[i], "-j") && i+1<argc) num_threads = parse_unsigned(argv[++i]);
+		else if (program == NULL && strchr(argv[i], '=') == NULL) program = argv[i];
+		else if (!parse_setting(argv[i], &job, &init)) fail(string("unexpected argument ") + argv[i]);
+	}
+	if (program == NULL){
+		cerr << "usage: " << argv[0] << " <program> <setting>* [-i interval] [-k max clusters] [-w warm-up] [-j threads]" << endl;
+		return -1;
+	}
+	if (interval == 0 || max_clusters == 0) fail("the interval and the number of clusters must be positive");
+	if (!valid_params(job.params)) fail("invalid processor configuration");
+	if (!valid_init(&init, job.memory_size)) fail("initialization out of range");
+
+	Program_Cache cache;
+	job.program = cache.get(program);
+	job.init = &init;
+	const program_image_t &image = *job.program;
+	ostream discard(NULL);
+
+	//random projection of the basic block vectors (none if there are few blocks)
+	vector<unsigned> block_of, block_end;
+	unsigned num_blocks = find_basic_blocks(image, block_of, block_end);
+	unsigned dims = min(num_blocks, (unsigned)PROJECTED_DIMS);
+	mt19937 random(1);
+	vector<point_t> projection(num_blocks, point_t(dims, 0));
+	for (unsigned b=0; b<num_blocks; b++){
+		if (num_blocks <= PROJECTED_DIMS) projection[b][b] = 1;
+		else for (unsigned d=0; d<dims; d++) projection[b][d] = uniform_real_distribution<double>(-1, 1)(random);
+	}
+
+	//profiling: one basic block vector per interval
+	sim_ooo *sim = new_simulator(job, discard);
+	vector<point_t> points;
+	vector<unsigned long long> start;   //first instruction of each interval
+	vector<unsigned long long> length;  //instructions of each interval
+	vector<unsigned long long> counts(num_blocks, 0);
+	vector<unsigned> touched;
+	unsigned long long executed = 0;
+	bool done = false;
+	while (!done){
+		//runs up to the end of the current block (the PC is always the start of a block)
+		unsigned index = (sim->PC - image.base_address) / 4;
+		done = !sim->isValidPC(sim->PC) || image.instructions[index].opcode == EOP;
+		unsigned long long n = 0;
+		if (!done){
+			unsigned block = block_of[index];
+			unsigned remaining = block_end[block] - index;
+			n = sim->fast_forward(remaining);
+			if (counts[block] == 0) touched.push_back(block);
+			counts[block] += n;
+			executed += n;
+			done = (n < remaining);
+		}
+		unsigned long long first = start.empty() ? 0 : start.back() + length.back();
+		if (executed - first >= interval || (done && executed > first)){
+			point_t point(dims, 0);
+			for (unsigned t=0; t<touched.size(); t++){
+				unsigned b = touched[t];
+				double share = (double)counts[b] / (executed - first);
+				for (unsigned d=0; d<dims; d++) point[d] += share * projection[b][d];
+				counts[b] = 0;
+			}
+			touched.clear();
+			points.push_back(point);
+			start.push_back(first);
+			length.push_back(executed - first);
+		}
+	}
+	delete sim;
+	if (points.empty()) fail("the program executes no instruction");
+
+	//clustering
+	vector<clustering_t> clusterings;
+	for (unsigned k=1; k<=max_clusters && k<=points.size(); k++){
+		clustering_t best;
+		for (unsigned s=0; s<KMEANS_SEEDS; s++){
+			clustering_t c = kmeans(points, k, random);
+			if (s == 0 || c.distortion < best.distortion) best = c;
+		}
+		best.bic = bic(points, best);
+		clusterings.push_back(best);
+	}
+	double low = clusterings[0].bic, high = clusterings[0].bic;
+	for (unsigned i=1; i<clusterings.size(); i++){
+		low = min(low, clusterings[i].bic);
+		high = max(high, clusterings[i].bic);
+	}
+	unsigned chosen = 0;
+	while (clusterings[chosen].bic < low + 0.9 * (high - low)) chosen++;
+	const clustering_t &clustering = clusterings[chosen];
+
+	//representative interval and weight of each (non-empty) cluster
+	vector<unsigned> simpoints;
+	vector<double> weights;
+	for (unsigned j=0; j<clustering.k; j++){
+		unsigned representative = points.size();
+		unsigned long long instructions = 0;
+		for (unsigned p=0; p<points.size(); p++){
+			if (clustering.cluster[p] != j) continue;
+			instructions += length[p];
+			if (representative == points.size() || distance2(points[p], clustering.centres[j]) < distance2(points[representative], clustering.centres[j])) representative = p;
+		}
+		if (representative == points.size()) continue;
+		simpoints.push_back(representative);
+		weights.push_back((double)instructions / executed);
+	}
+
+	//checkpoints: clones of the functional state before the warm-up of each representative interval
+	unsigned num_simpoints = simpoints.size();
+	vector<unsigned> order(num_simpoints);
+	for (unsigned s=0; s<num_simpoints; s++) order[s] = s;
+	sort(order.begin(), order.end(), [&](unsigned a, unsigned b){ return start[simpoints[a]] < start[simpoints[b]]; });
+	vector<sim_ooo *> checkpoints(num_simpoints);
+	vector<unsigned long long> warmups(num_simpoints);
+	sim = new_simulator(job, discard);
+	unsigned long long position = 0;
+	for (unsigned i=0; i<num_simpoints; i++){
+		unsigned s = order[i];
+		unsigned long long first = start[simpoints[s]];
+		unsigned long long checkpoint = (first > warmup) ? first - warmup : 0;
+		position += sim->fast_forward(checkpoint - position);
+		checkpoints[s] = sim->clone();
+		warmups[s] = first - checkpoint;
+	}
+	delete sim;
+
+	//detailed simulation of the representative intervals
+	vector<double> cpi(num_simpoints);
+	Thread_Pool pool(num_threads);
+	pool.run(num_simpoints, [&](unsigned s){
+		sim_ooo *checkpoint = checkpoints[s];
+		checkpoint->run_instructions(warmups[s]);
+		unsigned long long first_cycle = checkpoint->current_cycle;
+		unsigned long long first_instruction = checkpoint->get_instructions_executed();
+		checkpoint->run_instructions(length[simpoints[s]]);
+		unsigned long long instructions = checkpoint->get_instructions_executed() - first_instruction;
+		cpi[s] = (instructions == 0) ? 0 : (double)(checkpoint->current_cycle - first_cycle) / instructions;
+		delete checkpoint;
+	});
+
+	double estimate = 0;
+	unsigned long long detailed = 0;
+	for (unsigned s=0; s<num_simpoints; s++){
+		estimate += weights[s] * cpi[s];
+		detailed += warmups[s] + length[simpoints[s]];
+	}
+	cout << "program        " << program << endl;
+	cout << "instructions   " << executed << " in " << points.size() << " intervals of " << interval
+	     << " (" << num_blocks << " basic blocks)" << endl;
+	cout << "clusters       " << num_simpoints << " (of at most " << max_clusters << "), " << detailed << " instructions in detail" << endl;
+	cout << "interval,first instruction,instructions,weight,CPI" << endl;
+	cout << fixed << setprecision(4);
+	for (unsigned i=0; i<num_simpoints; i++){
+		unsigned s = order[i];
+		cout << simpoints[s] << "," << start[simpoints[s]] << "," << length[simpoints[s]] << "," << weights[s] << "," << cpi[s] << endl;
+	}
+	cout << "CPI            " << estimate << endl;
+	cout << "IPC            " << 1 / estimate << endl;
+	return 0;
+}
@@ -0,0 +1,299 @@
+#include "job.h"
+#include "lockstep.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+using namespace std;
+
+/* Design-space sweep.
+   Runs every processor configuration in the Cartesian product of the parameter ranges
+   given in a sweep file on a set of programs, and writes cycles and IPC of every
+   (configuration, program) point as CSV.
+
+   usage: sweep <sweep file> [-j threads] [-o output file] [-l]
+
+   With -l, the configurations that differ only in the latencies of the execution units are
+   simulated in lockstep batches (see lockstep.h) instead of one by one; the results are the
+   same. Configurations that differ in any other parameter (station or unit counts, widths...)
+   are still simulated one by one.
+
+   Sweep file, one directive per line ('#' starts a comment):
+     <parameter> <range>     range of a processor parameter (see param_names in job.cc):
+                             "n", "lo-hi", "lo-hi/step" or "a,b,c"
+     memory <bytes>          size of the data memory (default 1MB)
+     budget <cycles>         cycles after which a run is abandoned (default 1000000, 0 = none)
+     probe <n>               number of programs the pruning is based on (default 1, 0 = no pruning)
+     program <file> <init>*  program to run; each init is Rn=int, Fn=float or address=value
+                             (a value containing a '.' is stored as a float)
+
+   Pruning: all the configurations first run the probe programs (the first "probe" programs
+   of the file). A configuration is then dominated if the configuration one step smaller in
+   a single parameter (one resource less, or one latency step longer) takes no more cycles
+   on every probe program; dominated configurations do not run the remaining programs and
+   are flagged in the output. */
+
+//program to run and initial state of its registers and memory
+typedef struct{
+	string filename;
+	const program_image_t *image;
+	init_t init;
+} program_t;
+
+typedef struct{
+	vector<unsigned> values[NUM_PARAMS]; //sorted, without duplicates
+	unsigned stride[NUM_PARAMS];         //index distance between neighbouring values of a parameter
+	unsigned num_configs;
+	unsigned memory_size;
+	unsigned long long budget;
+	unsigned probe;
+	vector<program_t> programs;
+} sweep_t;
+
+//parses "n", "lo-hi", "lo-hi/step" or "a,b,c"
+static vector<unsigned> parse_range(const string &token){
+	vector<unsigned> values;
+	size_t dash = token.find('-');
+	if (dash != string::npos){
+		size_t slash = token.find('/', dash);
+		unsigned lo = parse_unsigned(token.substr(0, dash));
+		unsigned hi = parse_unsigned(token.substr(dash+1, slash == string::npos ? string::npos : slash-dash-1));
+		unsigned step = (slash == string::npos) ? 1 : parse_unsigned(token.substr(slash+1));
+		if (step == 0 || hi < lo) fail("invalid range " + token);
+		for (unsigned v=lo; v<=hi; v+=step) values.push_back(v);
+	} else {
+		stringstream list(token);
+		string value;
+		while (getline(list, value, ',')) values.push_back(parse_unsigned(value));
+	}
+	sort(values.begin(), values.end());
+	values.erase(unique(values.begin(), values.end()), values.end());
+	if (values.empty() || values[0] == 0) fail("parameters must be positive: " + token);
+	return values;
+}
+
+static program_t parse_program(stringstream &line, Program_Cache &cache){
+	program_t program;
+	string token;
+	line >> program.filename;
+	program.image = cache.get(program.filename);
+	while (line >> token)
+		if (!parse_init(token, &program.init)) fail("invalid initialization " + token);
+	return program;
+}
+
+static void parse_sweep(const char *filename, sweep_t &sweep, Program_Cache &cache){
+	ifstream fin(filename);
+	if (!fin.is_open()) fail(string("open file ") + filename + " failed!");
+
+	for (unsigned p=0; p<NUM_PARAMS; p++) sweep.values[p].assign(1, param_defaults[p]);
+	sweep.memory_size = 1024*1024;
+	sweep.budget = 1000000;
+	sweep.probe = 1;
+
+	string text;
+	while (getline(fin, text)){
+		text = text.substr(0, text.find('#'));
+		stringstream line(text);
+		string key, value;
+		if (!(line >> key)) continue;
+		if (key == "program"){
+			sweep.programs.push_back(parse_program(line, cache));
+			continue;
+		}
+		if (!(line >> value)) fail("missing value for " + key);
+		if (key == "memory") sweep.memory_size = parse_unsigned(value);
+		else if (key == "budget") sweep.budget = parse_count(value);
+		else if (key == "probe") sweep.probe = parse_unsigned(value);
+		else {
+			unsigned p = find_param(key);
+			if (p == NUM_PARAMS) fail("unknown parameter " + key);
+			sweep.values[p] = parse_range(value);
+		}
+	}
+	if (sweep.programs.empty()) fail("no program to run");
+	if (sweep.probe > sweep.programs.size()) sweep.probe = sweep.programs.size();
+	for (unsigned i=0; i<sweep.programs.size(); i++)
+		if (!valid_init(&sweep.programs[i].init, sweep.memory_size)) fail("initialization out of range for " + sweep.programs[i].filename);
+
+	unsigned long long num_configs = 1;
+	for (int p=NUM_PARAMS-1; p>=0; p--){
+		sweep.stride[p] = (unsigned)num_configs;
+		num_configs *= sweep.values[p].size();
+		if (num_configs * sweep.programs.size() >= UNDEFINED) fail("too many configurations");
+	}
+	sweep.num_configs = (unsigned)num_configs;
+}
+
+//returns the value of each parameter in the given configuration
+static void decode_config(const sweep_t &sweep, unsigned config, unsigned *params){
+	for (unsigned p=0; p<NUM_PARAMS; p++)
+		params[p] = sweep.values[p][(config / sweep.stride[p]) % sweep.values[p].size()];
+}
+
+//returns the configuration one step smaller than "config" in parameter p (UNDEFINED if there is none)
+static unsigned smaller_config(const sweep_t &sweep, unsigned config, unsigned p){
+	unsigned index = (config / sweep.stride[p]) % sweep.values[p].size();
+	bool latency = (p >= PARAM_LAT(0)) && ((p - PARAM_LAT(0)) % 2 == 0);
+	if (latency){
+		if (index+1 == sweep.values[p].size()) return UNDEFINED;
+		return config + sweep.stride[p];
+	}
+	if (index == 0) return UNDEFINED;
+	return config - sweep.stride[p];
+}
+
+int main(int argc, char **argv){
+
+	const char *sweep_file = NULL;
+	const char *output_file = NULL;
+	unsigned num_threads = 0;
+	bool lockstep = false;
+	for (int i=1; i<argc; i++){
+		if (!strcmp(argv[i], "-j") && i+1<argc) num_threads = parse_unsigned(argv[++i]);
+		else if (!strcmp(argv[i], "-l")) lockstep = true;
+		else if (!strcmp(argv[i], "-o") && i+1<argc) output_file = argv[++i];
+		else if (sweep_file == NULL) sweep_file = argv[i];
+		else fail(string("unexpected argument ") + argv[i]);
+	}
+	if (sweep_file == NULL){
+		cerr << "usage: " << argv[0] << " <sweep file> [-j threads] [-o output file] [-l]" << endl;
+		cerr << "  -l: run the configurations that differ only in unit latencies in lockstep batches" << endl;
+		return -1;
+	}
+
+	sweep_t sweep;
+	Program_Cache cache;
+	parse_sweep(sweep_file, sweep, cache);
+	unsigned num_programs = sweep.programs.size();
+
+	//configurations to simulate
+	vector<unsigned> configs;
+	unsigned params[NUM_PARAMS];
+	for (unsigned c=0; c<sweep.num_configs; c++){
+		decode_config(sweep, c, params);
+		if (valid_params(params)) configs.push_back(c);
+	}
+
+	vector<result_t> points(sweep.num_configs * num_programs);
+	vector<bool> simulated(sweep.num_configs * num_programs, false);
+	vector<bool> pruned(sweep.num_configs, false);
+
+	Thread_Pool pool(num_threads);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	//runs the programs in [first, last) on the given configurations
+	auto run_programs = [&](const vector<unsigned> &on, unsigned first, unsigned last){
+		unsigned count = last - first;
+		if (lockstep){
+			//one task per lockstep batch and program
+			map<vector<unsigned>, vector<unsigned> > batches;
+			for (unsigned i=0; i<on.size(); i++){
+				unsigned config_params[NUM_PARAMS];
+				decode_config(sweep, on[i], config_params);
+				batches[lockstep_key(config_params)].push_back(on[i]);
+			}
+			vector<vector<unsigned> > groups;
+			for (map<vector<unsigned>, vector<unsigned> >::iterator it = batches.begin(); it != batches.end(); it++) groups.push_back(it->second);
+			pool.run(groups.size() * count, [&](unsigned task){
+				const vector<unsigned> &group = groups[task / count];
+				unsigned program = first + task % count;
+				vector<unsigned> lane_params(group.size() * NUM_PARAMS);
+				vector<const unsigned *> lanes;
+				for (unsigned i=0; i<group.size(); i++){
+					decode_config(sweep, group[i], &lane_params[i*NUM_PARAMS]);
+					lanes.push_back(&lane_params[i*NUM_PARAMS]);
+				}
+				job_t job;
+				job.program = sweep.programs[program].image;
+				job.init = &sweep.programs[program].init;
+				job.memory_size = sweep.memory_size;
+				job.budget = sweep.budget;
+				vector<result_t> results;
+				simulate_lockstep(job, lanes, results);
+				for (unsigned i=0; i<group.size(); i++) points[group[i]*num_programs + program] = results[i];
+			});
+		} else {
+			pool.run(on.size() * count, [&](unsigned task){
+				unsigned config = on[task / count];
+				unsigned program = first + task % count;
+				job_t job;
+				job.program = sweep.programs[program].image;
+				job.init = &sweep.programs[program].init;
+				decode_config(sweep, config, job.params);
+				job.memory_size = sweep.memory_size;
+				job.budget = sweep.budget;
+				points[config*num_programs + program] = simulate(job);
+			});
+		}
+		for (unsigned i=0; i<on.size(); i++)
+			for (unsigned p=first; p<last; p++) simulated[on[i]*num_programs + p] = true;
+	};
+
+	if (sweep.probe == 0){
+		run_programs(configs, 0, num_programs);
+	} else {
+		//probe programs first, on all the configurations
+		unsigned probe = sweep.probe;
+		run_programs(configs, 0, probe);
+
+		//prunes the configurations dominated by a smaller neighbour
+		vector<unsigned> survivors;
+		for (unsigned i=0; i<configs.size(); i++){
+			unsigned c = configs[i];
+			for (unsigned p=0; p<NUM_PARAMS && !pruned[c]; p++){
+				unsigned s = smaller_config(sweep, c, p);
+				if (s == UNDEFINED) continue;
+				bool dominated = true;
+				for (unsigned q=0; q<probe && dominated; q++)
+					dominated = (points[s*num_programs + q].cycles <= points[c*num_programs + q].cycles);
+				pruned[c] = dominated;
+			}
+			if (!pruned[c]) survivors.push_back(c);
+		}
+
+		//then the remaining programs, on the configurations that survived
+		if (probe < num_programs) run_programs(survivors, probe, num_programs);
+	}
+
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	//writes the results
+	ofstream fout;
+	if (output_file != NULL){
+		fout.open(output_file);
+		if (!fout.is_open()) fail(string("open file ") + output_file + " failed!");
+	}
+	ostream &out = (output_file != NULL) ? fout : cout;
+	for (unsigned p=0; p<NUM_PARAMS; p++) out << param_names[p] << ",";
+	out << "program,cycles,ipc,pruned" << endl;
+	unsigned num_simulations = 0;
+	unsigned num_pruned = 0;
+	for (unsigned i=0; i<configs.size(); i++){
+		unsigned c = configs[i];
+		if (pruned[c]) num_pruned++;
+		decode_config(sweep, c, params);
+		for (unsigned p=0; p<num_programs; p++){
+			if (!simulated[c*num_programs + p]) continue;
+			num_simulations++;
+			const result_t &point = points[c*num_programs + p];
+			for (unsigned q=0; q<NUM_PARAMS; q++) out << params[q] << ",";
+			out << sweep.programs[p].filename << ",";
+			if (point.cycles == TIMEOUT) out << "timeout,0";
+			else out << point.cycles << "," << (float)point.instructions/point.cycles;
+			out << "," << (pruned[c] ? 1 : 0) << endl;
+		}
+	}
+
+	cerr << configs.size() << " configurations (" << num_pruned << " pruned), " << num_simulations << " simulations on "
+	     << pool.size() << " threads in " << elapsed << "s" << endl;
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "thread_pool.h"
+#include <thread>
+#include <vector>
+
+Thread_Pool::Thread_Pool(unsigned num_threads){
+	if (num_threads == 0) num_threads = thread::hardware_concurrency();
+	if (num_threads == 0) num_threads = 1;
+	this->num_threads = num_threads;
+	queues = new worker_queue_t[num_threads];
+}
+
+Thread_Pool::~Thread_Pool(){
+	delete [] queues;
+}
+
+unsigned Thread_Pool::size(){
+	return num_threads;
+}
+
+bool Thread_Pool::pop(unsigned w, unsigned &task){
+	lock_guard<mutex> guard(queues[w].lock);
+	if (queues[w].tasks.empty()) return false;
+	task = queues[w].tasks.front();
+	queues[w].tasks.pop_front();
+	return true;
+}
+
+bool Thread_Pool::steal(unsigned w, unsigned &task){
+	for (unsigned i=1; i<num_threads; i++){
+		worker_queue_t &victim = queues[(w+i) % num_threads];
+		lock_guard<mutex> guard(victim.lock);
+		if (victim.tasks.empty()) continue;
+		task = victim.tasks.back();
+		victim.tasks.pop_back();
+		return true;
+	}
+	return false;
+}
+
+void Thread_Pool::work(unsigned w, const function<void(unsigned)> &task){
+	unsigned t;
+	while (pop(w, t) || steal(w, t)) task(t);
+}
+
+void Thread_Pool::run(unsigned num_tasks, const function<void(unsigned)> &task){
+	//each worker starts with a contiguous block of tasks: neighbouring tasks tend to cost
+	//the same, so stealing from the opposite end of the block balances the load
+	for (unsigned w=0; w<num_threads; w++){
+		unsigned first = (unsigned)((unsigned long long)num_tasks * w / num_threads);
+		unsigned last = (unsigned)((unsigned long long)num_tasks * (w+1) / num_threads);
+		for (unsigned t=first; t<last; t++) queues[w].tasks.push_back(t);
+	}
+
+	//the calling thread is worker 0
+	vector<thread> workers;
+	for (unsigned w=1; w<num_threads; w++) workers.push_back(thread(&Thread_Pool::work, this, w, cref(task)));
+	work(0, task);
+	for (unsigned w=0; w<workers.size(); w++) workers[w].join();
+}
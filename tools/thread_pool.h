@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <deque>
+#include <mutex>
+#include <functional>
+
+using namespace std;
+
+/* Work-stealing thread pool for the simulation tools.
+   Every worker owns a queue of task indexes: it takes work from the front of its own
+   queue and, when that is empty, steals from the back of the other workers' queues.
+   Tasks are independent simulations, so no task is ever added while the pool runs. */
+class Thread_Pool{
+
+	//task queue of one worker
+	struct worker_queue_t{
+		mutex lock;
+		deque<unsigned> tasks;
+	};
+
+	unsigned num_threads;
+	worker_queue_t *queues;
+
+	//pops a task from the front of the queue of worker "w" (false if the queue is empty)
+	bool pop(unsigned w, unsigned &task);
+
+	//steals a task from the back of the queue of any worker other than "w"
+	bool steal(unsigned w, unsigned &task);
+
+	//body of worker "w": runs tasks until all the queues are empty
+	void work(unsigned w, const function<void(unsigned)> &task);
+
+public:
+	//creates a pool of num_threads workers (0 = one per hardware thread)
+	Thread_Pool(unsigned num_threads=0);
+
+	~Thread_Pool();
+
+	//returns the number of workers
+	unsigned size();
+
+	//runs task(i) for i in [0, num_tasks) on the workers, returns when all of them are done
+	void run(unsigned num_tasks, const function<void(unsigned)> &task);
+};
+
+#endif /*THREAD_POOL_H_*/